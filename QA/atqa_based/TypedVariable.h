@@ -0,0 +1,34 @@
+#ifndef ANALYSISTREEQA_TYPEDVARIABLE_H
+#define ANALYSISTREEQA_TYPEDVARIABLE_H
+
+#include "AnalysisTree/Variable.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// @brief Typed expressions for computed AnalysisTree::Variable-s.
+/// The expression is a callable taking its fields as typed arguments, e.g. (float ct) or (float nSig0, float nSig2, int selFlag).
+/// The number of fields is checked against the expression arity at compile time, the values are passed by index without
+/// copying the field buffer or bounds checking, and no temporary container is created per candidate.
+namespace TypedVariable {
+
+template<typename... Args, typename F, size_t... I>
+inline double Apply(const F& func, const std::vector<double>& values, std::index_sequence<I...>) {
+  return static_cast<double>(func(static_cast<Args>(values[I])...));
+}
+
+/// @brief Builds the Variable named name from fields, whose value is func(fields...)
+/// Usage: Make<float>("properLifetime", {{"Candidates", "fLiteCt"}}, [](float ct) { return 100./2.99792458*ct; });
+template<typename... Args, typename F>
+AnalysisTree::Variable Make(const std::string& name, const AnalysisTree::Field (&fields)[sizeof...(Args)], F func) {
+  static_assert(sizeof...(Args) > 0, "TypedVariable::Make(): at least one field is needed");
+  return AnalysisTree::Variable(name, std::vector<AnalysisTree::Field>(std::begin(fields), std::end(fields)),
+                                [func](std::vector<double>& values) { return Apply<Args...>(func, values, std::index_sequence_for<Args...>{}); });
+}
+
+} // namespace TypedVariable
+
+#endif //ANALYSISTREEQA_TYPEDVARIABLE_H
@@ -4,6 +4,7 @@
 #include "corrBg_qa.h"
 
 #include "Task.hpp"
+#include "TypedVariable.h"
 
 #include <AnalysisTree/HelperFunctions.hpp>
 #include <AnalysisTree/TaskManager.hpp>
@@ -33,7 +34,7 @@ std::string GetCutName(size_t iCut, const std::vector<float>& ranges, const std:
 std::string GetDecayFormula(const Decay& decay);
 
 SimpleCut rapidityCut = RangeCut(Variable::FromString(recBranchName + ".fLiteY"), rapidityRanges.first, rapidityRanges.second);
-Variable properLifetime("properLifetime", {{recBranchName, "fLiteCt"}}, [](const std::vector<double>& v) { return 100./2.997*v.at(0); });
+Variable properLifetime = TypedVariable::Make<float>("properLifetime", {{recBranchName, "fLiteCt"}}, [](float ct) { return 100./2.997*ct; });
 
 enum KfSigBgStatus : int {
   kBackground = 0,
@@ -3,6 +3,7 @@
 //
 
 #include "Task.hpp"
+#include "TypedVariable.h"
 
 #include "AnalysisTree/HelperFunctions.hpp"
 #include "AnalysisTree/TaskManager.hpp"
@@ -38,7 +39,7 @@ const std::vector<std::string> bdtClasses{"fLiteMlScoreFirstClass", "fLiteMlScor
 // auto TCuts = HelperFunctions::CreateRangeCuts(lifetimeRanges, "T_", recBranchName + ".fKFT");
 SimpleCut rapidityCut = RangeCut(Variable::FromString(recBranchName + ".fLiteY"), rapidityRanges.first, rapidityRanges.second);
 
-Variable properLifetime("properLifetime", {{recBranchName, "fLiteCt"}}, [](const std::vector<double>& v) { return 100./2.99792458*v.at(0); });
+Variable properLifetime = TypedVariable::Make<float>("properLifetime", {{recBranchName, "fLiteCt"}}, [](float ct) { return 100./2.99792458*ct; });
 std::vector<SimpleCut> TCuts{
   RangeCut(properLifetime, lifetimeRanges.at(0), lifetimeRanges.at(1), ("T_" + HelperFunctions::ToStringWithPrecision(lifetimeRanges.at(0), 2) + "_" + HelperFunctions::ToStringWithPrecision(lifetimeRanges.at(1), 2)).c_str()),
   RangeCut(properLifetime, lifetimeRanges.at(1), lifetimeRanges.at(2), ("T_" + HelperFunctions::ToStringWithPrecision(lifetimeRanges.at(1), 2) + "_" + HelperFunctions::ToStringWithPrecision(lifetimeRanges.at(2), 2)).c_str()),
@@ -3,6 +3,7 @@
 #include "AnalysisTree/TaskManager.hpp"
 #include "AnalysisTree/Variable.hpp"
 #include "Task.hpp"
+#include "TypedVariable.h"
 
 #include <string>
 
@@ -52,15 +53,15 @@ void PidQA(QA::Task& task, const std::string& recBranchName) {
   std::vector<Variable> varPt;
   varPt.resize(nProngSpecies);
 
-  varPt.at(kProton) = Variable("pT_" + ProngSpecies.at(kProton).first,
+  varPt.at(kProton) = TypedVariable::Make<float, float, int>("pT_" + ProngSpecies.at(kProton).first,
                                {{recBranchName, "fLitePtProng0"}, {recBranchName, "fLitePtProng2"}, {recBranchName, "fLiteCandidateSelFlag"}},
-                               [](const std::vector<double>& var) { return var.at(2) == 1 ? var.at(0) : var.at(1); });
-  varPt.at(kKaon) = Variable("pT_" + ProngSpecies.at(kKaon).first,
+                               [](float pT0, float pT2, int selFlag) { return selFlag == 1 ? pT0 : pT2; });
+  varPt.at(kKaon) = TypedVariable::Make<float>("pT_" + ProngSpecies.at(kKaon).first,
                              {{recBranchName, "fLitePtProng1"}},
-                             [](const std::vector<double>& var) { return var.at(0); });
-  varPt.at(kPion) = Variable("pT_" + ProngSpecies.at(kPion).first,
+                             [](float pT1) { return pT1; });
+  varPt.at(kPion) = TypedVariable::Make<float, float, int>("pT_" + ProngSpecies.at(kPion).first,
                                {{recBranchName, "fLitePtProng0"}, {recBranchName, "fLitePtProng2"}, {recBranchName, "fLiteCandidateSelFlag"}},
-                               [](const std::vector<double>& var) { return var.at(2) == 1 ? var.at(1) : var.at(0); });
+                               [](float pT0, float pT2, int selFlag) { return selFlag == 1 ? pT2 : pT0; });
 
 
   SimpleCut bdtBgScoreCut = SimpleCut(std::vector<std::string>{recBranchName + ".fKFPt", recBranchName + ".fLiteMlScoreFirstClass"},
@@ -5,6 +5,7 @@
 #include "AnalysisTree/TaskManager.hpp"
 #include "AnalysisTree/Variable.hpp"
 #include "Task.hpp"
+#include "TypedVariable.h"
 
 using namespace AnalysisTree;
 
@@ -75,13 +76,13 @@ void PidQA(QA::Task& task) {
   std::vector<std::pair<std::string, std::string>> ProngSpecies{{"Pr", "p"}, {"Ka", "K"}, {"Pi", "#pi"}};
 
   for(int iDet=0; iDet<nPidDetectors; iDet++) {
-    varPid.at(iDet).at(kProton) = Variable("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(0).first,
+    varPid.at(iDet).at(kProton) = TypedVariable::Make<float, float, int>("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(0).first,
                                            {{"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pr0"}, {"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pr2"}, {"Candidates", "Lite_fCandidateSelFlag"}},
-                                           []( std::vector<double>& var ) { return var.at(2)==1 ? var.at(0) : var.at(2)==2 ? var.at(1) : UndefValueFloat; });
+                                           []( float nSig0, float nSig2, int selFlag ) { return selFlag==1 ? nSig0 : selFlag==2 ? nSig2 : UndefValueFloat; });
 
-    varPid.at(iDet).at(kPion) = Variable("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(2).first,
+    varPid.at(iDet).at(kPion) = TypedVariable::Make<float, float, int>("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(2).first,
                                          {{"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pi0"}, {"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pi2"}, {"Candidates", "Lite_fCandidateSelFlag"}},
-                                         []( std::vector<double>& var ) { return var.at(2)==1 ? var.at(1) : var.at(2)==2 ? var.at(0) : UndefValueFloat; });
+                                         []( float nSig0, float nSig2, int selFlag ) { return selFlag==1 ? nSig2 : selFlag==2 ? nSig0 : UndefValueFloat; });
 
     varPid.at(iDet).at(kKaon) = Variable::FromString("Candidates.Lite_fNSig" + PidDetectors.at(iDet) + "Ka1");
     varPid.at(iDet).at(kKaon).SetName("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(1).first);
@@ -214,13 +215,13 @@ std::vector<SimpleCut> DefinePidSelectionCuts() {
   std::vector<std::pair<std::string, std::string>> ProngSpecies{{"Pr", "p"}, {"Ka", "K"}, {"Pi", "#pi"}};
 
   for(int iDet=0; iDet<nPidDetectors; iDet++) {
-    varPid.at(iDet).at(kProton) = Variable("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(0).first,
+    varPid.at(iDet).at(kProton) = TypedVariable::Make<float, float, int>("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(0).first,
                                            {{"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pr0"}, {"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pr2"}, {"Candidates", "Lite_fCandidateSelFlag"}},
-                                           []( std::vector<double>& var ) { return var.at(2)==1 ? var.at(0) : var.at(2)==2 ? var.at(1) : UndefValueFloat; });
+                                           []( float nSig0, float nSig2, int selFlag ) { return selFlag==1 ? nSig0 : selFlag==2 ? nSig2 : UndefValueFloat; });
 
-    varPid.at(iDet).at(kPion) = Variable("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(2).first,
+    varPid.at(iDet).at(kPion) = TypedVariable::Make<float, float, int>("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(2).first,
                                          {{"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pi0"}, {"Candidates", "Lite_fNSig" + PidDetectors.at(iDet) + "Pi2"}, {"Candidates", "Lite_fCandidateSelFlag"}},
-                                         []( std::vector<double>& var ) { return var.at(2)==1 ? var.at(1) : var.at(2)==2 ? var.at(0) : UndefValueFloat; });
+                                         []( float nSig0, float nSig2, int selFlag ) { return selFlag==1 ? nSig2 : selFlag==2 ? nSig0 : UndefValueFloat; });
 
     varPid.at(iDet).at(kKaon) = Variable::FromString("Candidates.Lite_fNSig" + PidDetectors.at(iDet) + "Ka1");
     varPid.at(iDet).at(kKaon).SetName("nSig" + PidDetectors.at(iDet) + ProngSpecies.at(1).first);
@@ -1,31 +1,23 @@
-SCORES_P="0.00 0.01 0.02 0.03 0.04 0.05 0.06 0.07 0.08 0.09 0.10 0.11 0.12 0.13 0.14 0.15 0.16 0.17 0.18 0.19 0.20 0.21 0.22 0.23 0.24 0.25 0.26 0.27 0.28 0.29 0.30 0.31 0.32 0.33 0.34 0.35 0.36 0.37 0.38 0.39 0.40 0.41 0.42 0.43 0.44 0.45 0.46 0.47 0.48 0.49 0.50 0.51 0.52 0.53 0.54 0.55 0.56 0.57 0.58 0.59 0.60 0.61 0.62 0.63 0.64 0.65 0.66 0.67 0.68 0.69 0.70 0.71 0.72 0.73 0.74 0.75 0.76 0.77 0.78 0.79 0.80 0.81 0.82 0.83 0.84 0.85 0.86 0.87 0.88 0.89 0.90 0.91 0.92 0.93 0.94 0.95 0.96 0.97 0.98 0.99"
-
-SCORES_NP=$SCORES_P
-
 FILENAME=$1
+# optional trial number, under which the results are recorded in the RawYieldStore
+TRIAL=${2:-0}
 
+# all the BDT score thresholds are fitted by a single runMassFitter process,
+# see BatchPlaceholder and BatchRange in the config
 for tarsig in 'NP'
 do
-if [ tarsig == "P" ]; then
-SCORES=$SCORES_P
-else
-SCORES=$SCORES_NP
-fi
-for score in $SCORES
+CONFIG=config_massfitter.${tarsig}.json
+sed -e "s/TARGET_SIGNAL_TO_BE_REPLACED/$tarsig/g" -e "s/\"Trial\": [0-9]*/\"Trial\": $TRIAL/" $FILENAME > $CONFIG
+runMassFitter $CONFIG
+rm $CONFIG
+done
+mkdir -p mInvFit mInvFit_Residuals
+for file in RawYields_Lc.*_Residuals.pdf
 do
-mkdir -p $score
-cd $score
-cp ../$FILENAME .
-sed -i "s/BDT_SCORE_TO_BE_REPLACED/$score/g" $FILENAME
-sed -i "s/TARGET_SIGNAL_TO_BE_REPLACED/$tarsig/g" $FILENAME
-runMassFitter $FILENAME
-mv fileOut.root ../RawYields_Lc.${tarsig}gt${score}.root
-mv fileOut.pdf ../mInvFit.${tarsig}gt${score}.pdf
-mv fileOut_Residuals.pdf ../mInvFit_Residuals.${tarsig}gt${score}.pdf
-cd -
-rm -r $score
+base=${file#RawYields_Lc.}
+mv $file ./mInvFit_Residuals/mInvFit_Residuals.${base%_Residuals.pdf}.pdf
 done
+for file in RawYields_Lc.*.pdf
+do
+mv $file ./mInvFit/mInvFit.${file#RawYields_Lc.}
 done
-mkdir -p mInvFit mInvFit_Residuals
-mv mInvFit.*pdf ./mInvFit
-mv mInvFit_Residuals*pdf ./mInvFit_Residuals
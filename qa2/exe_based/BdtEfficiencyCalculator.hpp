@@ -7,7 +7,10 @@
 
 #include <TH2.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 class BdtEfficiencyCalculator {
 public:
@@ -29,7 +32,7 @@ public:
     void Run() {
       for(int iBin=1; iBin<=x_n_bins_; iBin++) {
         for(int jBin=1; jBin<=y_n_bins_; jBin++) {
-          const double eff = GetEfficiency(iBin, jBin);
+          const double eff = GetEfficiency(iBin, jBin).first;
           histo_eff_->SetBinContent(iBin, jBin, eff);
           histo_rej_->SetBinContent(iBin, jBin, 1. - eff);
         } // iBin
@@ -45,11 +48,41 @@ public:
 
     TH2D* GetRejectionHistogram() const { return histo_rej_; }
 
+    // returns efficiency (a fraction, not in %) and its error; the error is not stored in the output histograms
+    std::pair<double, double> GetEfficiency(int binx, int biny) const {
+      const int ny = y_n_bins_ + 1;
+      const int fromX = x_is_upper_cut_ ? 1 : binx+1;
+      const int toX = x_is_upper_cut_ ? binx-1 : x_n_bins_;
+      const int fromY = y_is_upper_cut_ ? 1 : biny+1;
+      const int toY = y_is_upper_cut_ ? biny-1 : y_n_bins_;
+      // the edge and corner bins pass with fractions f = 1/2 and 1/4
+      double integral{0.};     // sum of f*w
+      double passErr2{0.};     // sum of f*err^2
+      double passErr2Sq{0.};   // sum of f^2*err^2
+      auto addRectangle = [&](double fraction, int fromXR, int toXR, int fromYR, int toYR) {
+        integral += fraction * RectangleSum(sat_sumw_, ny, fromXR, toXR, fromYR, toYR);
+        const double err2 = RectangleSum(sat_sumw2_, ny, fromXR, toXR, fromYR, toYR);
+        passErr2 += fraction * err2;
+        passErr2Sq += fraction * fraction * err2;
+      };
+      if(toX > fromX && toY > fromY) addRectangle(1., fromX, toX, fromY, toY);
+      if(toY > fromY) addRectangle(0.5, binx, binx, fromY, toY);
+      if(toX > fromX) addRectangle(0.5, fromX, toX, biny, biny);
+      addRectangle(0.25, binx, binx, biny, biny);
+      const double eff = integral / integral_;
+      // the passed part is a subset of the total: each bin enters the efficiency with the derivative (f - eff)/integral,
+      // i.e. the weighted-binomial sum of err^2 * (f - eff)^2 = err2_pass*(1-eff)^2 + err2_fail*eff^2 for f = 0, 1
+      const double effErr2 = passErr2Sq - 2.*eff*passErr2 + eff*eff*integral_err2_;
+      return {eff, std::sqrt(std::max(effErr2, 0.)) / integral_};
+    }
+
 private:
     void Init() {
       x_n_bins_ = histo_in_->GetNbinsX();
       y_n_bins_ = histo_in_->GetNbinsY();
       integral_ = histo_in_->Integral(1, x_n_bins_, 1, y_n_bins_);
+      BuildSummedAreaTables();
+      integral_err2_ = sat_sumw2_.back();
 
       histo_eff_ = dynamic_cast<TH2D*>(histo_in_->Clone());
       histo_eff_->Reset();
@@ -69,16 +102,26 @@ private:
       histo_rej_->GetZaxis()->SetTitle("(1 - #varepsilon), %");
     }
 
-    double GetEfficiency(int binx, int biny) const {
-      const int fromX = x_is_upper_cut_ ? 1 : binx+1;
-      const int toX = x_is_upper_cut_ ? binx-1 : x_n_bins_;
-      const int fromY = y_is_upper_cut_ ? 1 : biny+1;
-      const int toY = y_is_upper_cut_ ? biny-1 : y_n_bins_;
-      const double integralInternal = (toX > fromX && toY > fromY) ? histo_in_->Integral(fromX, toX, fromY, toY) : 0.;
-      const double integralEdgeVert = toY > fromY ? histo_in_->Integral(binx, binx, fromY, toY) / 2 : 0.;
-      const double integralEdgeHoriz = toX > fromX ? histo_in_->Integral(fromX, toX, biny, biny) / 2 : 0.;
-      const double integralCorner = histo_in_->GetBinContent(binx, biny) / 4;
-      return (integralInternal + integralEdgeVert + integralEdgeHoriz + integralCorner) / integral_;
+    // Summed-area tables of bin contents and squared bin errors: sat[i][j] = sum over bins (1..i, 1..j),
+    // stored with a zero row and column in front, so that any rectangle integral is read out in O(1)
+    void BuildSummedAreaTables() {
+      const int nx = x_n_bins_ + 1;
+      const int ny = y_n_bins_ + 1;
+      sat_sumw_.assign(nx * ny, 0.);
+      sat_sumw2_.assign(nx * ny, 0.);
+      for(int iBin=1; iBin<=x_n_bins_; iBin++) {
+        for(int jBin=1; jBin<=y_n_bins_; jBin++) {
+          const double content = histo_in_->GetBinContent(iBin, jBin);
+          const double error = histo_in_->GetBinError(iBin, jBin);
+          const int idx = iBin*ny + jBin;
+          sat_sumw_.at(idx) = content + sat_sumw_.at(idx-ny) + sat_sumw_.at(idx-1) - sat_sumw_.at(idx-ny-1);
+          sat_sumw2_.at(idx) = error*error + sat_sumw2_.at(idx-ny) + sat_sumw2_.at(idx-1) - sat_sumw2_.at(idx-ny-1);
+        } // jBin
+      } // iBin
+    }
+
+    static double RectangleSum(const std::vector<double>& sat, int ny, int fromX, int toX, int fromY, int toY) {
+      return sat[toX*ny + toY] - sat[(fromX-1)*ny + toY] - sat[toX*ny + fromY-1] + sat[(fromX-1)*ny + fromY-1];
     }
 
     const TH2* histo_in_;
@@ -89,6 +132,9 @@ private:
     int x_n_bins_;
     int y_n_bins_;
     double integral_;
+    double integral_err2_;
+    std::vector<double> sat_sumw_;
+    std::vector<double> sat_sumw2_;
 };
 
 #endif //QA2_BDTEFFICIENCYCALCULATOR_HPP
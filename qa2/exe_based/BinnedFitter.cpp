@@ -0,0 +1,213 @@
+#include "BinnedFitter.hpp"
+
+#include <Fit/Fitter.h>
+#include <Math/Functor.h>
+#include <TFitResult.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+BinnedFitter::BinnedFitter(const TH1* histo, double xMin, double xMax, Statistic statistic) : statistic_(statistic) {
+  if(histo == nullptr) throw std::runtime_error("BinnedFitter::BinnedFitter(): histo == nullptr");
+
+  const int nBins = histo->GetNbinsX();
+  for(int iBin = 1; iBin <= nBins; iBin++) {
+    const double x = histo->GetBinCenter(iBin);
+    if(x < xMin || x > xMax) continue;
+    const double error = histo->GetBinError(iBin);
+    if(statistic_ == Statistic::kChi2 && error <= 0) continue;
+    x_.push_back(x);
+    y_.push_back(histo->GetBinContent(iBin));
+    weight_.push_back(statistic_ == Statistic::kChi2 ? 1. / (error * error) : 1.);
+  }
+  mu_.resize(x_.size());
+}
+
+double BinnedFitter::Evaluate(const Model& model, const double* par) const {
+  const size_t nBins = x_.size();
+  model.shape_(x_.data(), nBins, par, mu_.data());
+
+  double result = 0.;
+  if(statistic_ == Statistic::kChi2) {
+    for(size_t i = 0; i < nBins; i++) {
+      const double residual = y_[i] - mu_[i];
+      result += residual * residual * weight_[i];
+    }
+  } else {
+    for(size_t i = 0; i < nBins; i++) {
+      const double mu = std::max(mu_[i], DBL_MIN);
+      const double y = y_[i];
+      result += mu - y + (y > 0 ? y * std::log(y / mu) : 0.);
+    }
+    result *= 2;
+  }
+
+  return result;
+}
+
+void BinnedFitter::EvaluateGradient(const Model& model, const double* par, size_t nPars, double* grad) const {
+  if(model.gradient_ == nullptr) throw std::runtime_error("BinnedFitter::EvaluateGradient(): the model has no gradient");
+
+  const size_t nBins = x_.size();
+  model.shape_(x_.data(), nBins, par, mu_.data());
+
+  grad_.resize(nPars);
+  std::fill(grad, grad + nPars, 0.);
+  for(size_t i = 0; i < nBins; i++) {
+    const double coefficient = statistic_ == Statistic::kChi2 ? -2 * (y_[i] - mu_[i]) * weight_[i]
+                                                              : 2 * (1 - y_[i] / std::max(mu_[i], DBL_MIN));
+    model.gradient_(&x_[i], par, grad_.data());
+    for(size_t iPar = 0; iPar < nPars; iPar++) {
+      grad[iPar] += coefficient * grad_[iPar];
+    }
+  }
+}
+
+TFitResultPtr BinnedFitter::Fit(TF1* func, const Model& model) const {
+  if(func == nullptr) throw std::runtime_error("BinnedFitter::Fit(): func == nullptr");
+  if(model.shape_ == nullptr) throw std::runtime_error("BinnedFitter::Fit(): model.shape_ == nullptr");
+
+  const int nPars = func->GetNpar();
+
+  ROOT::Fit::Fitter fitter;
+  fitter.Config().SetMinimizer("Minuit2", "Migrad");
+  fitter.Config().SetParamsSettings(nPars, func->GetParameters());
+  SetParameterSettings(fitter.Config(), func);
+
+  auto value = [this, &model](const double* par) { return Evaluate(model, par); };
+  const bool isChi2 = statistic_ == Statistic::kChi2;
+  if(model.gradient_ != nullptr) {
+    auto gradient = [this, &model, nPars](const double* par, double* grad) { EvaluateGradient(model, par, nPars, grad); };
+    fitter.FitFCN(ROOT::Math::GradFunctor(value, gradient, nPars), nullptr, x_.size(), isChi2);
+  } else {
+    fitter.FitFCN(ROOT::Math::Functor(value, nPars), nullptr, x_.size(), isChi2);
+  }
+
+  func->SetFitResult(fitter.Result());
+  if(!isChi2) {
+    // the FCN minimum is not a chi2, the Pearson one of the fitted function is stored instead, as in TH1::Fit("L")
+    model.shape_(x_.data(), x_.size(), fitter.Result().GetParams(), mu_.data());
+    double chi2 = 0.;
+    for(size_t i = 0; i < x_.size(); i++) {
+      if(mu_[i] <= 0) continue;
+      chi2 += (y_[i] - mu_[i]) * (y_[i] - mu_[i]) / mu_[i];
+    }
+    func->SetChisquare(chi2);
+  }
+  return TFitResultPtr(new TFitResult(fitter.Result()));
+}
+
+void BinnedFitter::SetParameterSettings(ROOT::Fit::FitConfig& config, const TF1* func) {
+  const int nPars = func->GetNpar();
+  for(int iPar = 0; iPar < nPars; iPar++) {
+    auto& parSettings = config.ParSettings(iPar);
+    const double value = func->GetParameter(iPar);
+    const double error = func->GetParError(iPar);
+    parSettings.Set(func->GetParName(iPar), value, error > 0 ? error : (value != 0 ? 0.3 * std::abs(value) : 0.1));
+    double parMin, parMax;
+    func->GetParLimits(iPar, parMin, parMax);
+    if(parMin * parMax != 0 && parMin >= parMax) {
+      parSettings.Fix();
+    } else if(parMin < parMax) {
+      parSettings.SetLimits(parMin, parMax);
+    }
+  }
+}
+
+size_t SimultaneousBinnedFitter::AddSpectrum(const TH1* histo, TF1* func, const BinnedFitter::Model& model, const std::vector<int>& sharedPars) {
+  if(func == nullptr) throw std::runtime_error("SimultaneousBinnedFitter::AddSpectrum(): func == nullptr");
+  if(model.shape_ == nullptr) throw std::runtime_error("SimultaneousBinnedFitter::AddSpectrum(): model.shape_ == nullptr");
+
+  const int nPars = func->GetNpar();
+  ROOT::Fit::FitConfig config(nPars);
+  BinnedFitter::SetParameterSettings(config, func);
+
+  Spectrum spectrum{BinnedFitter(histo, func->GetXmin(), func->GetXmax(), statistic_), func, model, {}, std::vector<double>(nPars), std::vector<double>(nPars)};
+  for(int iPar = 0; iPar < nPars; iPar++) {
+    const bool isShared = std::find(sharedPars.begin(), sharedPars.end(), iPar) != sharedPars.end();
+    if(isShared && shared_par_indices_.count(iPar) > 0) {
+      spectrum.par_indices_.emplace_back(shared_par_indices_.at(iPar));
+      continue;
+    }
+    auto parSettings = config.ParSettings(iPar);
+    if(!isShared) parSettings.SetName(parSettings.Name() + "_" + std::to_string(spectra_.size()));
+    par_settings_.emplace_back(parSettings);
+    spectrum.par_indices_.emplace_back(par_settings_.size() - 1);
+    if(isShared) shared_par_indices_.emplace(iPar, par_settings_.size() - 1);
+  }
+
+  spectra_.emplace_back(std::move(spectrum));
+  return spectra_.size() - 1;
+}
+
+void SimultaneousBinnedFitter::GatherParameters(Spectrum& spectrum, const double* par) const {
+  const size_t nPars = spectrum.par_indices_.size();
+  for(size_t iPar = 0; iPar < nPars; iPar++) {
+    spectrum.par_[iPar] = par[spectrum.par_indices_[iPar]];
+  }
+}
+
+double SimultaneousBinnedFitter::Evaluate(const double* par) {
+  double result = 0.;
+  for(auto& spectrum : spectra_) {
+    GatherParameters(spectrum, par);
+    result += spectrum.fitter_.Evaluate(spectrum.model_, spectrum.par_.data());
+  }
+  return result;
+}
+
+void SimultaneousBinnedFitter::EvaluateGradient(const double* par, double* grad) {
+  std::fill(grad, grad + par_settings_.size(), 0.);
+  for(auto& spectrum : spectra_) {
+    GatherParameters(spectrum, par);
+    const size_t nPars = spectrum.par_indices_.size();
+    spectrum.fitter_.EvaluateGradient(spectrum.model_, spectrum.par_.data(), nPars, spectrum.grad_.data());
+    for(size_t iPar = 0; iPar < nPars; iPar++) {
+      grad[spectrum.par_indices_[iPar]] += spectrum.grad_[iPar];
+    }
+  }
+}
+
+TFitResultPtr SimultaneousBinnedFitter::Fit() {
+  if(spectra_.empty()) throw std::runtime_error("SimultaneousBinnedFitter::Fit(): no spectra added");
+
+  const unsigned int nPars = par_settings_.size();
+  size_t nBins{0};
+  bool isGradient{true};
+  for(const auto& spectrum : spectra_) {
+    nBins += spectrum.fitter_.GetNBins();
+    isGradient &= spectrum.model_.gradient_ != nullptr;
+  }
+
+  ROOT::Fit::Fitter fitter;
+  fitter.Config().SetMinimizer("Minuit2", "Migrad");
+  fitter.Config().SetParamsSettings(par_settings_);
+
+  auto value = [this](const double* par) { return Evaluate(par); };
+  const bool isChi2 = statistic_ == BinnedFitter::Statistic::kChi2;
+  if(isGradient) {
+    auto gradient = [this](const double* par, double* grad) { EvaluateGradient(par, grad); };
+    fitter.FitFCN(ROOT::Math::GradFunctor(value, gradient, nPars), nullptr, nBins, isChi2);
+  } else {
+    fitter.FitFCN(ROOT::Math::Functor(value, nPars), nullptr, nBins, isChi2);
+  }
+
+  const ROOT::Fit::FitResult& result = fitter.Result();
+  for(auto& spectrum : spectra_) {
+    spectrum.func_->SetFitResult(result, spectrum.par_indices_.data());
+    GatherParameters(spectrum, result.GetParams());
+    int nFree{0};
+    for(const int iPar : spectrum.par_indices_) {
+      if(!result.IsParameterFixed(iPar)) nFree++;
+    }
+    const int nSpectrumBins = static_cast<int>(spectrum.fitter_.GetNBins());
+    spectrum.func_->SetChisquare(spectrum.fitter_.Evaluate(spectrum.model_, spectrum.par_.data()));
+    spectrum.func_->SetNumberFitPoints(nSpectrumBins);
+    spectrum.func_->SetNDF(std::max(nSpectrumBins - nFree, 0));
+  }
+  return TFitResultPtr(new TFitResult(result));
+}
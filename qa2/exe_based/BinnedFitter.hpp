@@ -0,0 +1,102 @@
+#ifndef QA2_BINNEDFITTER_HPP
+#define QA2_BINNEDFITTER_HPP
+
+#include <Fit/FitConfig.h>
+#include <Fit/ParameterSettings.h>
+#include <TF1.h>
+#include <TFitResultPtr.h>
+#include <TH1.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+/// Lightweight binned fitter of a 1D histogram with a shape from Shapes.hpp.
+/// The histogram bins within the fit range are copied into contiguous arrays once, the model is evaluated over all of them
+/// in one call (see EvaluateShapeBatch()), and the chi2 or the Poisson likelihood is minimised by Minuit2 through
+/// a plain FCN, optionally with the analytic gradient. This avoids the per-point overhead of the generic TH1::Fit() machinery.
+/// The bins are selected by their centres within the range; in the chi2 mode the bins with zero error are skipped,
+/// as in TH1::Fit(). The Evaluate*() methods use an internal buffer, so one fitter must not be used concurrently.
+class BinnedFitter {
+ public:
+  enum class Statistic {
+    kChi2,      // sum of ((content - model) / error)^2, the same as the default of TH1::Fit()
+    kPoissonNLL // 2 * (negative log-likelihood ratio) of Poisson-distributed contents (Baker-Cousins), for raw counts
+  };
+
+  using BatchShape = void (*)(const double* x, size_t nX, const double* par, double* out);
+  using Gradient = void (*)(const double* x, const double* par, double* grad);
+
+  struct Model {
+    BatchShape shape_{nullptr};
+    Gradient gradient_{nullptr}; // the fit runs without the analytic gradient if nullptr
+  };
+
+  BinnedFitter() = delete;
+  BinnedFitter(const TH1* histo, double xMin, double xMax, Statistic statistic=Statistic::kChi2);
+  virtual ~BinnedFitter() = default;
+
+  /// Fits the model with the parameters' starting values, steps and limits taken from func (as in TH1::Fit()),
+  /// stores the results into func and returns them
+  TFitResultPtr Fit(TF1* func, const Model& model) const;
+
+  double Evaluate(const Model& model, const double* par) const;
+  void EvaluateGradient(const Model& model, const double* par, size_t nPars, double* grad) const;
+
+  size_t GetNBins() const { return x_.size(); }
+
+  /// The parameter settings of TH1::Fit(): TF1::FixParameter() sets equal limits (1, 1 for zero value)
+  static void SetParameterSettings(ROOT::Fit::FitConfig& config, const TF1* func);
+
+ private:
+  Statistic statistic_;
+  std::vector<double> x_;      // bin centres
+  std::vector<double> y_;      // bin contents
+  std::vector<double> weight_; // 1 / error^2 for chi2
+  mutable std::vector<double> mu_;   // model values buffer
+  mutable std::vector<double> grad_; // model gradient buffer
+};
+
+/// Simultaneous binned fit of several histograms, each with its own model, with one likelihood (the sum of
+/// the spectra's chi2 or Poisson terms). The models' parameters are mapped onto one global set, so that
+/// a parameter (e.g. the peak position and width) can be shared by all the spectra, while the others (the yields
+/// and the backgrounds) stay per spectrum. The spectra are evaluated one after another within each FCN call.
+class SimultaneousBinnedFitter {
+ public:
+  explicit SimultaneousBinnedFitter(BinnedFitter::Statistic statistic=BinnedFitter::Statistic::kChi2) : statistic_(statistic) {}
+  virtual ~SimultaneousBinnedFitter() = default;
+
+  /// Adds the histogram fitted with the model within the range of func; the starting values, steps and limits
+  /// are taken from func (as in BinnedFitter::Fit()). The parameters listed in sharedPars are common for all
+  /// the spectra, their settings are taken from the first spectrum. Returns the index of the spectrum
+  size_t AddSpectrum(const TH1* histo, TF1* func, const BinnedFitter::Model& model, const std::vector<int>& sharedPars);
+
+  /// Fits all the spectra together and stores into each func its parameters and errors, its own FCN term as chi2 and
+  /// the number of its bins less its free parameters as NDF; returns the global result.
+  /// The gradient is used if all the models provide it
+  TFitResultPtr Fit();
+
+  /// Indices of the spectrum's parameters in the global result
+  const std::vector<int>& GetParIndices(size_t iSpectrum) const { return spectra_.at(iSpectrum).par_indices_; }
+
+ private:
+  struct Spectrum {
+    BinnedFitter fitter_;
+    TF1* func_;
+    BinnedFitter::Model model_;
+    std::vector<int> par_indices_;
+    std::vector<double> par_;  // local parameters buffer
+    std::vector<double> grad_; // local gradient buffer
+  };
+
+  void GatherParameters(Spectrum& spectrum, const double* par) const;
+  double Evaluate(const double* par);
+  void EvaluateGradient(const double* par, double* grad);
+
+  BinnedFitter::Statistic statistic_;
+  std::vector<Spectrum> spectra_;
+  std::vector<ROOT::Fit::ParameterSettings> par_settings_;
+  std::map<int, int> shared_par_indices_; // global index of each shared parameter by its index in the model
+};
+
+#endif //QA2_BINNEDFITTER_HPP
@@ -0,0 +1,106 @@
+#include "FitResultCache.hpp"
+
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TSystem.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+/// 64-bit FNV-1a hash
+class Hasher {
+ public:
+  void Add(const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  void Add(double value) { Add(&value, sizeof(value)); }
+  void Add(const std::string& text) { Add(text.data(), text.size()); }
+
+  std::string GetHex() const {
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash_;
+    return stream.str();
+  }
+
+ private:
+  uint64_t hash_{14695981039346656037ULL};
+};
+}
+
+FitResultCache::FitResultCache(std::string directory) : directory_(std::move(directory)) {
+  if(IsEnabled() && gSystem->mkdir(directory_.c_str(), true) != 0 && gSystem->AccessPathName(directory_.c_str())) {
+    throw std::runtime_error("FitResultCache::FitResultCache(): cannot create directory " + directory_);
+  }
+}
+
+std::string FitResultCache::MakeKey(const TH1* histo, double xMin, double xMax, const std::string& configuration) {
+  if(histo == nullptr) throw std::runtime_error("FitResultCache::MakeKey(): histo == nullptr");
+
+  Hasher hasher;
+  hasher.Add(xMin);
+  hasher.Add(xMax);
+  const TAxis* axis = histo->GetXaxis();
+  for(int iBin = axis->FindFixBin(xMin), lastBin = axis->FindFixBin(xMax); iBin <= lastBin; ++iBin) {
+    hasher.Add(axis->GetBinLowEdge(iBin));
+    hasher.Add(axis->GetBinUpEdge(iBin));
+    hasher.Add(histo->GetBinContent(iBin));
+    hasher.Add(histo->GetBinError(iBin));
+  }
+  hasher.Add(configuration);
+
+  return hasher.GetHex();
+}
+
+std::string FitResultCache::DescribeFunction(const TF1* func) {
+  if(func == nullptr) throw std::runtime_error("FitResultCache::DescribeFunction(): func == nullptr");
+
+  std::ostringstream stream;
+  stream << std::setprecision(17) << func->GetName() << " " << func->GetTitle() << " " << func->GetXmin() << " " << func->GetXmax();
+  for(int iPar = 0, nPars = func->GetNpar(); iPar < nPars; ++iPar) {
+    double parMin, parMax;
+    func->GetParLimits(iPar, parMin, parMax);
+    stream << " " << func->GetParameter(iPar) << " " << func->GetParError(iPar) << " " << parMin << " " << parMax;
+  }
+
+  return stream.str();
+}
+
+void FitResultCache::Put(const std::string& key, const TObject& result) const {
+  if(!IsEnabled()) return;
+
+  TDirectory::TContext context; // restores gDirectory
+  const std::string fileName = FileName(key);
+  const std::string tmpFileName = fileName + ".tmp" + std::to_string(gSystem->GetPid());
+  {
+    TFile file(tmpFileName.c_str(), "recreate");
+    if(file.IsZombie()) throw std::runtime_error("FitResultCache::Put(): cannot create file " + tmpFileName);
+    file.WriteTObject(&result, "result");
+    file.Close();
+  }
+  if(std::rename(tmpFileName.c_str(), fileName.c_str()) != 0) {
+    throw std::runtime_error("FitResultCache::Put(): cannot rename " + tmpFileName + " into " + fileName);
+  }
+}
+
+TObject* FitResultCache::Read(const std::string& key) const {
+  if(!IsEnabled()) return nullptr;
+
+  const std::string fileName = FileName(key);
+  if(gSystem->AccessPathName(fileName.c_str())) return nullptr; // true if the file does not exist
+
+  TDirectory::TContext context; // restores gDirectory
+  TFile file(fileName.c_str(), "read");
+  if(file.IsZombie()) return nullptr;
+  TObject* result = file.Get<TObject>("result");
+  file.Close();
+
+  return result;
+}
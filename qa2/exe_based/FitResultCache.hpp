@@ -0,0 +1,41 @@
+#ifndef QA2_FITRESULTCACHE_HPP
+#define QA2_FITRESULTCACHE_HPP
+
+#include <TF1.h>
+#include <TH1.h>
+#include <TObject.h>
+
+#include <string>
+
+/// On-disk cache of fit results, so that re-running a fit with unchanged input and settings skips the minimisation.
+/// A result is keyed by a hash of the fitted histogram (bin edges, contents and errors within the fit range),
+/// of the fit range and of a text describing the full fit configuration (shape, starting values, limits, options).
+/// Each result is a ROOT object (e.g. TFitResult or RooFitResult) stored in its own file <directory>/<key>.root;
+/// the file is written under a temporary name and renamed, so that concurrent processes can share the directory.
+class FitResultCache {
+ public:
+  /// An empty directory disables the cache
+  explicit FitResultCache(std::string directory);
+  virtual ~FitResultCache() = default;
+
+  bool IsEnabled() const { return !directory_.empty(); }
+
+  static std::string MakeKey(const TH1* histo, double xMin, double xMax, const std::string& configuration);
+
+  /// Configuration of a TF1 before the fit: name, title, starting values, errors (steps) and limits of the parameters
+  static std::string DescribeFunction(const TF1* func);
+
+  /// Returns the cached result, or nullptr if there is none; the caller takes the ownership
+  template<typename T>
+  T* Get(const std::string& key) const { return dynamic_cast<T*>(Read(key)); }
+
+  void Put(const std::string& key, const TObject& result) const;
+
+ private:
+  TObject* Read(const std::string& key) const;
+  std::string FileName(const std::string& key) const { return directory_ + "/" + key + ".root"; }
+
+  std::string directory_;
+};
+
+#endif //QA2_FITRESULTCACHE_HPP
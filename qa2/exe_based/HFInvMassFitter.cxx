@@ -20,6 +20,9 @@
 
 #include "HFInvMassFitter.h"
 
+#include "FitResultCache.hpp"
+#include "TemplatePdf.h"
+
 #include <RooAddPdf.h>
 #include <RooCrystalBall.h>
 #include <RooDataHist.h>
@@ -31,7 +34,8 @@
 #include <RooGenericPdf.h>
 #include <RooGlobalFunc.h>
 #include <RooHist.h>
-#include <RooHistPdf.h>
+#include <RooHistError.h>
+#include <RooMinimizer.h>
 #include <RooPlot.h>
 #include <RooPolynomial.h>
 #include <RooRealVar.h>
@@ -40,6 +44,7 @@
 #include <TColor.h>
 #include <TDatabasePDG.h>
 #include <TFile.h>
+#include <TH1D.h>
 #include <TLine.h>
 #include <TNamed.h>
 #include <TPaveText.h>
@@ -50,9 +55,18 @@
 #include <Rtypes.h>
 #include <RtypesCore.h>
 
+#include <sys/wait.h> // wait
+#include <unistd.h>   // fork, getpid, _exit
+
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 
@@ -146,11 +160,26 @@ HFInvMassFitter::HFInvMassFitter() : TNamed(),
                                      mIntegralBkg(0),
                                      mHistoTemplateRefl(nullptr),
                                      mHistoTemplateCorrelBg(nullptr),
+                                     mCorrelBgNSmooth(0),
                                      mDrawBgPrefit(kFALSE),
                                      mDrawCorrelBg(kFALSE),
                                      mHighlightPeakRegion(kFALSE),
                                      mRandomGen(nullptr),
-                                     mRandomSeed(-1)
+                                     mRandomSeed(-1),
+                                     mWarmStartParameters(),
+                                     mIsWarmStart(kFALSE),
+                                     mFitStatus(-1),
+                                     mFitNCalls(0),
+                                     mIsWarmStartFallback(kFALSE),
+                                     mEvalBackend(""),
+                                     mFitStrategy(-1),
+                                     mFitCacheDirectory(""),
+                                     mHeadless(kFALSE),
+                                     mHistoToyPullRawYield(nullptr),
+                                     mHistoToyPullMean(nullptr),
+                                     mHistoToyPullSigma(nullptr),
+                                     mHistoToyRawYield(nullptr),
+                                     mToyNFailed(0)
 {
   // default constructor
 }
@@ -245,11 +274,26 @@ HFInvMassFitter::HFInvMassFitter(const TH1* histoToFit,
                                                      mIntegralBkg(0),
                                                      mHistoTemplateRefl(nullptr),
                                                      mHistoTemplateCorrelBg(nullptr),
+                                                     mCorrelBgNSmooth(0),
                                                      mDrawBgPrefit(kFALSE),
                                                      mDrawCorrelBg(kFALSE),
                                                      mHighlightPeakRegion(kFALSE),
                                                      mRandomGen(nullptr),
-                                                     mRandomSeed(-1)
+                                                     mRandomSeed(-1),
+                                                     mWarmStartParameters(),
+                                                     mIsWarmStart(kFALSE),
+                                                     mFitStatus(-1),
+                                                     mFitNCalls(0),
+                                                     mIsWarmStartFallback(kFALSE),
+                                     mEvalBackend(""),
+                                     mFitStrategy(-1),
+                                     mFitCacheDirectory(""),
+                                     mHeadless(kFALSE),
+                                     mHistoToyPullRawYield(nullptr),
+                                     mHistoToyPullMean(nullptr),
+                                     mHistoToyPullSigma(nullptr),
+                                     mHistoToyRawYield(nullptr),
+                                     mToyNFailed(0)
 {
   // standard constructor
   mHistoInvMass = dynamic_cast<TH1*>(histoToFit->Clone(histoToFit->GetTitle()));
@@ -260,29 +304,28 @@ HFInvMassFitter::~HFInvMassFitter()
 {
 
   /// destructor
+  /// the variables taken from the workspace (mean, sigma, DSCB and Voigt parameters) are owned by it;
+  /// the pdfs are deleted before the yields they depend on, and all of them before the workspace
   delete mHistoInvMass;
   delete mHistoTemplateRefl;
-  delete mRooMeanSgn;
-  delete mRooSigmaSgn;
+  delete mInvMassFrame;
+  delete mReflFrame;
+  delete mReflOnlyFrame;
+  delete mResidualFrame;
+  delete mTotalPdf;
   delete mSgnPdf;
   delete mBkgPdf;
   delete mReflPdf;
-  delete mTotalPdf;
+  delete mRooNCorrelBg;
+  delete mRooCorrelBg2Sgn;
   delete mRooNSgn;
   delete mRooNBkg;
   delete mRooNRefl;
-  delete mRooNCorrelBg;
-  delete mRooCorrelBg2Sgn;
-  delete mRooDscbAlphaL;
-  delete mRooDscbAlphaR;
-  delete mRooDscbNL;
-  delete mRooDscbNR;
-  delete mRooVoigtWidth;
-  delete mInvMassFrame;
-  delete mReflFrame;
-  delete mReflOnlyFrame;
-  delete mResidualFrame;
   delete mWorkspace;
+  delete mHistoToyPullRawYield;
+  delete mHistoToyPullMean;
+  delete mHistoToyPullSigma;
+  delete mHistoToyRawYield;
 }
 
 void HFInvMassFitter::writeBgFitInfo(TH1* hM, const bool isPreFit) const {
@@ -354,8 +397,10 @@ void HFInvMassFitter::doFit()
   }
   mass->setRange("bkg", mMass - mNSigmaForSgn * mSigmaSgn, mMass + mNSigmaForSgn * mSigmaSgn);    // TODO rename bkg to something more meaningful
   mass->setRange("full", mMinMass, mMaxMass);
-  mInvMassFrame = mass->frame(Title(Form("%s", mHistoInvMass->GetTitle()))); // define the frame to plot
-  dataHistogram.plotOn(mInvMassFrame, Name("data_c"));                       // plot data histogram on the frame
+  if (!mHeadless) {
+    mInvMassFrame = mass->frame(Title(Form("%s", mHistoInvMass->GetTitle()))); // define the frame to plot
+    dataHistogram.plotOn(mInvMassFrame, Name("data_c"));                       // plot data histogram on the frame
+  }
 
   auto CutHistoSidebands = [&](const TH1* histo) { // TODO generalize for various number of ranges
     const RooRealVar* mass = mWorkspace->var("mass");
@@ -395,40 +440,45 @@ void HFInvMassFitter::doFit()
     const double rooNSigSmear = 0.1 * mIntegralHisto;
     mRooNSgn = new RooRealVar("mRooNSig", "number of signal", randomizeInitialFitParameter(rooNSigLower, rooNSigUpper, rooNSigInitial, rooNSigSmear), rooNSigLower, rooNSigUpper); // signal yield
     mTotalPdf = new RooAddPdf("mMCFunc", "MC fit function", RooArgList(*sgnPdf), RooArgList(*mRooNSgn));       // create total pdf
-    if (!strcmp(mFitOption.Data(), "Chi2")) {
-      mTotalPdf->chi2FitTo(dataHistogram, Range("full"));
-    } else {
-      mTotalPdf->fitTo(dataHistogram, Range("full"), Extended());
-    }
+    mTotalPdfFitResult = fitTotalPdf(dataHistogram, "full");
     RooAbsReal* signalIntegralMc = mTotalPdf->createIntegral(*mass, NormSet(*mass), Range("signal")); // sig yield from fit
     calculateSignal(mRawYield, mRawYieldErr);        // calculate signal and signal error
     countSignal(mRawYieldCounted, mRawYieldCountedErr);
-    mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c")); // plot total function
-    mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / NDF
+    if (mHeadless) {
+      mChiSquareOverNdfTotal = computeChiSquareOverNdf(mTotalPdf, dataHistogram, {"full"});
+    } else {
+      mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c")); // plot total function
+      mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / NDF
+    }
   } else {                                           // data
    mBkgPdf = new RooAddPdf("mBkgPdf", "background fit function", RooArgList(*bkgPdf), RooArgList(*mRooNBkg));
     if (mTypeOfSgnPdf == GausSec) { // two peak fit
       if (!strcmp(mFitOption.Data(), "Chi2")) {
-        mBkgPdf->chi2FitTo(dataHistogram, Range("SBL,SBR,SEC"), Save());
+        mBkgPdf->chi2FitTo(dataHistogram, Range("SBL,SBR,SEC"), Save(), evalBackendArg(), strategyArg());
       } else {
-        mBkgPdf->fitTo(dataHistogram, Range("SBL,SBR,SEC"), Extended(), Save());
+        mBkgPdf->fitTo(dataHistogram, Range("SBL,SBR,SEC"), Extended(), Save(), evalBackendArg(), strategyArg());
       }
     } else { // single peak fit
       if (!strcmp(mFitOption.Data(), "Chi2")) {
-        mBkgPdf->chi2FitTo(dataHistogramSidebands, Save());
+        mBkgPdf->chi2FitTo(dataHistogramSidebands, Save(), evalBackendArg(), strategyArg());
       } else {
-        mBkgPdf->fitTo(dataHistogram, Range("SBL,SBR"), Extended(), Save());
+        mBkgPdf->fitTo(dataHistogram, Range("SBL,SBR"), Extended(), Save(), evalBackendArg(), strategyArg());
       }
       writeBgFitInfo(mHistoInvMass, true);
     }
-    // define the frame to evaluate background sidebands chi2 (bg pdf needs to be plotted within sideband ranges)
-    RooPlot* frameTemporary = mass->frame(Title(Form("%s_temp", mHistoInvMass->GetTitle())));
-    dataHistogram.plotOn(frameTemporary, Name("data_for_bkgchi2"));
-    mBkgPdf->plotOn(frameTemporary, Range("SBL", "SBR"), Name("Bkg_sidebands"));
-    mChiSquareOverNdfBkg = frameTemporary->chiSquare("Bkg_sidebands", "data_for_bkgchi2"); // calculate reduced chi2 / NDF of background sidebands (pre-fit)
-    delete frameTemporary;
+    if (mHeadless) {
+      // the same bins as the curve plotted with Range("SBL", "SBR") below, which covers SBL only ("SBR" is read as adjustNorm)
+      mChiSquareOverNdfBkg = computeChiSquareOverNdf(mBkgPdf, dataHistogram, {"SBL"});
+    } else {
+      // define the frame to evaluate background sidebands chi2 (bg pdf needs to be plotted within sideband ranges)
+      RooPlot* frameTemporary = mass->frame(Title(Form("%s_temp", mHistoInvMass->GetTitle())));
+      dataHistogram.plotOn(frameTemporary, Name("data_for_bkgchi2"));
+      mBkgPdf->plotOn(frameTemporary, Range("SBL", "SBR"), Name("Bkg_sidebands"));
+      mChiSquareOverNdfBkg = frameTemporary->chiSquare("Bkg_sidebands", "data_for_bkgchi2"); // calculate reduced chi2 / NDF of background sidebands (pre-fit)
+      delete frameTemporary;
+    }
     RooAbsPdf* mBkgPdfPrefit{nullptr};
-    if (mDrawBgPrefit) {
+    if (mDrawBgPrefit && !mHeadless) {
       mBkgPdfPrefit = dynamic_cast<RooAbsPdf*>(mBkgPdf->Clone());
       mBkgPdfPrefit->plotOn(mInvMassFrame, Range("full"), Name("Bkg_c_prefit"), NormRange("SBL,SBR"), LineColor(kGray));
       delete mBkgPdfPrefit;
@@ -457,9 +507,11 @@ void HFInvMassFitter::doFit()
     if (mHistoTemplateRefl) {
       RooAbsPdf* reflPdf = createReflectionFitFunction(mWorkspace); // create reflection pdf
       RooDataHist reflHistogram("reflHistogram", "refl for fit", *mass, Import(*mHistoTemplateRefl));
-      mReflFrame = mass->frame();
-      mReflOnlyFrame = mass->frame(Title(Form("%s", mHistoTemplateRefl->GetTitle())));
-      reflHistogram.plotOn(mReflOnlyFrame);
+      if (!mHeadless) {
+        mReflFrame = mass->frame();
+        mReflOnlyFrame = mass->frame(Title(Form("%s", mHistoTemplateRefl->GetTitle())));
+        reflHistogram.plotOn(mReflOnlyFrame);
+      }
       const double rooNReflLower = 0.;
       const double rooNReflUpper = mHistoTemplateRefl->Integral();
       const double rooNReflInitial = 0.5 * mHistoTemplateRefl->Integral();
@@ -467,61 +519,61 @@ void HFInvMassFitter::doFit()
       mRooNRefl = new RooRealVar("mNRefl", "number of reflection", randomizeInitialFitParameter(rooNReflLower, rooNReflUpper, rooNReflInitial, rooNReflSmear), rooNReflLower, rooNReflUpper);
       RooAddPdf reflFuncTemp("reflFuncTemp", "template reflection fit function", RooArgList(*reflPdf), RooArgList(*mRooNRefl));
       if (!strcmp(mFitOption.Data(), "Chi2")) {
-        reflFuncTemp.chi2FitTo(reflHistogram);
+        reflFuncTemp.chi2FitTo(reflHistogram, evalBackendArg(), strategyArg());
       } else {
-        reflFuncTemp.fitTo(reflHistogram, Extended());
+        reflFuncTemp.fitTo(reflHistogram, Extended(), evalBackendArg(), strategyArg());
+      }
+      if (!mHeadless) {
+        reflFuncTemp.plotOn(mReflOnlyFrame);
       }
-      reflFuncTemp.plotOn(mReflOnlyFrame);
 
       mRooNRefl->setVal(mReflOverSgn * estimatedSignal);
       mRooNRefl->setConstant(kTRUE);
       setReflFuncFixed(); // fix reflection pdf parameter
       mTotalPdf = new RooAddPdf("mTotalPdf", "background + signal + reflection fit function", RooArgList(*bkgPdf, *sgnPdf, *reflPdf), RooArgList(*mRooNBkg, *mRooNSgn, *mRooNRefl));
-      if (!strcmp(mFitOption.Data(), "Chi2")) {
-        mTotalPdf->chi2FitTo(dataHistogram);
-      } else {
-        mTotalPdf->fitTo(dataHistogram, Extended());
-      }
-      mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c"));
+      mTotalPdfFitResult = fitTotalPdf(dataHistogram);
       mReflPdf = new RooAddPdf("mReflPdf", "reflection fit function", RooArgList(*reflPdf), RooArgList(*mRooNRefl));
-      RooAddPdf reflBkgPdf("reflBkgPdf", "reflBkgPdf", RooArgList(*bkgPdf, *reflPdf), RooArgList(*mRooNBkg, *mRooNRefl));
-      reflBkgPdf.plotOn(mInvMassFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineStyle(7), LineColor(kRed + 1), Name("ReflBkg_c"));
-      plotBkg(mTotalPdf);                                                   // plot bkg pdf in total pdf
-      plotRefl(mTotalPdf);                                                  // plot reflection in total pdf
-      mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / NDF
+      if (mHeadless) {
+        mChiSquareOverNdfTotal = computeChiSquareOverNdf(mTotalPdf, dataHistogram, {"full"});
+      } else {
+        mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c"));
+        RooAddPdf reflBkgPdf("reflBkgPdf", "reflBkgPdf", RooArgList(*bkgPdf, *reflPdf), RooArgList(*mRooNBkg, *mRooNRefl));
+        reflBkgPdf.plotOn(mInvMassFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineStyle(7), LineColor(kRed + 1), Name("ReflBkg_c"));
+        plotBkg(mTotalPdf);                                                   // plot bkg pdf in total pdf
+        plotRefl(mTotalPdf);                                                  // plot reflection in total pdf
+        mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / NDF
 
-      // plot residual distribution
-      RooHist* residualHistogram = mInvMassFrame->residHist("data_c", "ReflBkg_c");
-      mResidualFrame = mass->frame(Title("Residual Distribution"));
-      mResidualFrame->addPlotable(residualHistogram, "p");
-      mSgnPdf->plotOn(mResidualFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineColor(kBlue));
+        // plot residual distribution
+        RooHist* residualHistogram = mInvMassFrame->residHist("data_c", "ReflBkg_c");
+        mResidualFrame = mass->frame(Title("Residual Distribution"));
+        mResidualFrame->addPlotable(residualHistogram, "p");
+        mSgnPdf->plotOn(mResidualFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineColor(kBlue));
+      }
     } else {
-      RooDataHist* corrBgDataHist{nullptr};
       if (mHistoTemplateCorrelBg == nullptr) {
         mTotalPdf = new RooAddPdf("mTotalPdf", "background + signal pdf", RooArgList(*bkgPdf, *sgnPdf), RooArgList(*mRooNBkg, *mRooNSgn));
       } else {
-        corrBgDataHist = new RooDataHist("corrBgDataHist", "correlated background histogram template", RooArgList(*mass), Import(*mHistoTemplateCorrelBg));
-        auto* corrBgPdf = new RooHistPdf("corrBgPdf", "correlated background template pdf", RooArgList(*mass), *corrBgDataHist, 1.);
+        auto* corrBgPdf = new TemplatePdf("corrBgPdf", "correlated background template pdf", *mass, mHistoTemplateCorrelBg, mCorrelBgNSmooth);
         mTotalPdf = new RooAddPdf("modelTotal", "background + signal + correlated bkg", RooArgList( *bkgPdf, *sgnPdf, *corrBgPdf ), RooArgList(*mRooNBkg, *mRooNSgn, *mRooNCorrelBg));
       }
-      if (!strcmp(mFitOption.Data(), "Chi2")) {
-        mTotalPdfFitResult = mTotalPdf->chi2FitTo(dataHistogram, Save());
-      } else {
-        mTotalPdfFitResult = mTotalPdf->fitTo(dataHistogram, Extended(), Save());
-      }
+      mTotalPdfFitResult = fitTotalPdf(dataHistogram);
       writeBgFitInfo(mHistoInvMass, false);
-      plotBkg(mTotalPdf);
-      if (corrBgDataHist != nullptr && mDrawCorrelBg) {
-        plotCorrelBg(mTotalPdf);
+      if (mHeadless) {
+        mChiSquareOverNdfTotal = computeChiSquareOverNdf(mTotalPdf, dataHistogram, {"full"});
+      } else {
+        plotBkg(mTotalPdf);
+        if (mHistoTemplateCorrelBg != nullptr && mDrawCorrelBg) {
+          plotCorrelBg(mTotalPdf);
+        }
+        mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c"), LineColor(kBlue));
+        mSgnPdf->plotOn(mInvMassFrame, Normalization(1.0, RooAbsReal::RelativeExpected), DrawOption("F"), FillColor(TColor::GetColorTransparent(kBlue, 0.2)), VLines());
+        mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / DNF
+        // plot residual distribution
+        mResidualFrame = mass->frame(Title("Residual Distribution"));
+        RooHist* residualHistogram = mInvMassFrame->residHist("data_c", "Bkg_c");
+        mResidualFrame->addPlotable(residualHistogram, "P");
+        mSgnPdf->plotOn(mResidualFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineColor(kBlue));
       }
-      mTotalPdf->plotOn(mInvMassFrame, Name("Tot_c"), LineColor(kBlue));
-      mSgnPdf->plotOn(mInvMassFrame, Normalization(1.0, RooAbsReal::RelativeExpected), DrawOption("F"), FillColor(TColor::GetColorTransparent(kBlue, 0.2)), VLines());
-      mChiSquareOverNdfTotal = mInvMassFrame->chiSquare("Tot_c", "data_c"); // calculate reduced chi2 / DNF
-      // plot residual distribution
-      mResidualFrame = mass->frame(Title("Residual Distribution"));
-      RooHist* residualHistogram = mInvMassFrame->residHist("data_c", "Bkg_c");
-      mResidualFrame->addPlotable(residualHistogram, "P");
-      mSgnPdf->plotOn(mResidualFrame, Normalization(1.0, RooAbsReal::RelativeExpected), LineColor(kBlue));
     }
     mass->setRange("bkgForSignificance", mRooMeanSgn->getVal() - mNSigmaForSgn * mRooSigmaSgn->getVal(), mRooMeanSgn->getVal() + mNSigmaForSgn * mRooSigmaSgn->getVal());
     bkgIntegral = mBkgPdf->createIntegral(*mass, NormSet(*mass), Range("bkgForSignificance"));
@@ -616,7 +668,7 @@ void HFInvMassFitter::fillWorkspace(RooWorkspace& workspace) const
     mean.setVal(mMass);
     mean.setConstant(kTRUE);
   }
-  RooRealVar sigma("sigma", "sigma for signal", mSigmaSgn, mSigmaSgn - 0.01, mSigmaSgn + 0.01);
+  RooRealVar sigma("sigma", "sigma for signal", mSigmaSgn, std::max(mSigmaSgn - 0.01, 0.), mSigmaSgn + 0.01);
   if (mFixedSigma) {
     sigma.setVal(mSigmaSgn);
     sigma.setConstant(kTRUE);
@@ -629,7 +681,7 @@ void HFInvMassFitter::fillWorkspace(RooWorkspace& workspace) const
   workspace.import(*sgnFuncGaus);
   delete sgnFuncGaus;
   // signal double Gaussian
-  RooRealVar sigmaDoubleGaus("sigmaDoubleGaus", "sigma2Gaus", mSigmaSgn, mSigmaSgn - 0.01, mSigmaSgn + 0.01);
+  RooRealVar sigmaDoubleGaus("sigmaDoubleGaus", "sigma2Gaus", mSigmaSgn, std::max(mSigmaSgn - 0.01, 0.), mSigmaSgn + 0.01);
   if (mBoundSigma) {
     sigmaDoubleGaus.setMax(mSigmaSgn * (1 + mParamSgn));
     sigmaDoubleGaus.setMin(mSigmaSgn * (1 - mParamSgn));
@@ -826,6 +878,7 @@ void HFInvMassFitter::fillWorkspace(RooWorkspace& workspace) const
 // draw fit output
 void HFInvMassFitter::drawFit(TVirtualPad* pad, Int_t writeFitInfo)
 {
+  checkNotHeadless("drawFit");
   gStyle->SetOptStat(0);
   gStyle->SetCanvasColor(0);
   gStyle->SetFrameFillColor(0);
@@ -887,6 +940,7 @@ void HFInvMassFitter::drawFit(TVirtualPad* pad, Int_t writeFitInfo)
 // draw residual distribution on canvas
 void HFInvMassFitter::drawResidual(TVirtualPad* pad)
 {
+  checkNotHeadless("drawResidual");
   pad->cd();
   mResidualFrame->GetYaxis()->SetTitle("");
   TPaveText* textInfo = new TPaveText(0.12, 0.65, 0.47, .89, "NDC");
@@ -932,6 +986,7 @@ void HFInvMassFitter::highlightPeakRegion(const RooPlot* plot, Color_t color, Wi
 // draw reflection distribution on canvas
 void HFInvMassFitter::drawReflection(TVirtualPad* pad)
 {
+  checkNotHeadless("drawReflection");
   pad->cd();
   mReflOnlyFrame->GetYaxis()->SetTitle("");
   mReflOnlyFrame->Draw();
@@ -1243,3 +1298,345 @@ double HFInvMassFitter::randomizeInitialFitParameter(double valueLower, double v
 
   return result;
 }
+
+// Fit of the total pdf. If warm-start parameters are given, the fit starts from them instead of the default initial values,
+// and if it fails, it is repeated from the default initial values
+RooFitResult* HFInvMassFitter::fitTotalPdf(RooDataHist& dataHistogram, const char* rangeName)
+{
+  std::unique_ptr<RooArgSet> parameters{mTotalPdf->getParameters(dataHistogram)};
+  std::unique_ptr<RooArgSet> defaultParameters{static_cast<RooArgSet*>(parameters->snapshot())};
+
+  bool isWarmStart{false};
+  for (auto* parameter : *parameters) {
+    auto* var = dynamic_cast<RooRealVar*>(parameter);
+    if (var == nullptr || var->isConstant()) {
+      continue;
+    }
+    const auto warmStartParameter = mWarmStartParameters.find(var->GetName());
+    if (warmStartParameter == mWarmStartParameters.end()) {
+      continue;
+    }
+    var->setVal(warmStartParameter->second); // clipped to the current range
+    isWarmStart = true;
+  }
+
+  mFitNCalls = 0;
+  mIsWarmStartFallback = kFALSE;
+
+  // the cache key covers the data, the pdf and its starting point (incl. the warm-start values), and the fit options
+  const FitResultCache cache(mFitCacheDirectory);
+  std::string cacheKey;
+  if (cache.IsEnabled()) {
+    std::ostringstream configuration;
+    configuration << std::setprecision(17) << mTotalPdf->GetName() << " " << mFitOption << " " << mEvalBackend << " " << mFitStrategy << " " << (rangeName ? rangeName : "");
+    for (const auto* parameter : *parameters) {
+      const auto* var = dynamic_cast<const RooRealVar*>(parameter);
+      if (var != nullptr) {
+        configuration << " " << var->GetName() << " " << var->getVal() << " " << var->getError() << " " << var->getMin() << " " << var->getMax() << " " << var->isConstant();
+      }
+    }
+    if (mHistoTemplateCorrelBg != nullptr) {
+      configuration << " " << FitResultCache::MakeKey(mHistoTemplateCorrelBg, mMinMass, mMaxMass, "TemplatePdf " + std::to_string(mCorrelBgNSmooth));
+    }
+    cacheKey = FitResultCache::MakeKey(mHistoInvMass, mMinMass, mMaxMass, configuration.str());
+    if (RooFitResult* cachedResult = cache.Get<RooFitResult>(cacheKey)) {
+      for (const auto* parameterFinal : cachedResult->floatParsFinal()) {
+        const auto* varFinal = dynamic_cast<const RooRealVar*>(parameterFinal);
+        auto* var = dynamic_cast<RooRealVar*>(parameters->find(parameterFinal->GetName()));
+        if (var == nullptr || varFinal == nullptr) {
+          throw std::runtime_error("HFInvMassFitter::fitTotalPdf(): the cached result does not match the pdf parameter " + std::string(parameterFinal->GetName()));
+        }
+        var->setVal(varFinal->getVal());
+        var->setError(varFinal->getError());
+      }
+      mFitStatus = cachedResult->status();
+      return cachedResult;
+    }
+  }
+
+  RooFitResult* result = minimizeTotalPdf(dataHistogram, rangeName);
+  if (isWarmStart && result->status() != 0) {
+    printf("HFInvMassFitter::fitTotalPdf(): the fit from the warm-start parameters failed (status %d), repeating it from the default ones\n", result->status());
+    delete result;
+    for (auto* parameter : *parameters) {
+      auto* var = dynamic_cast<RooRealVar*>(parameter);
+      const auto* defaultVar = dynamic_cast<const RooRealVar*>(defaultParameters->find(parameter->GetName()));
+      if (var == nullptr || defaultVar == nullptr || var->isConstant()) {
+        continue;
+      }
+      var->setVal(defaultVar->getVal());
+      var->setError(defaultVar->getError());
+    }
+    mIsWarmStartFallback = kTRUE;
+    result = minimizeTotalPdf(dataHistogram, rangeName);
+  }
+  mFitStatus = result->status();
+  if (cache.IsEnabled()) {
+    cache.Put(cacheKey, *result);
+  }
+  return result;
+}
+
+// fitTo() / chi2FitTo() with the options used in doFit(). In the warm-start mode, the equivalent minimisation
+// with RooMinimizer, which keeps the number of function calls
+RooFitResult* HFInvMassFitter::minimizeTotalPdf(RooDataHist& dataHistogram, const char* rangeName)
+{
+  if (!mIsWarmStart) {
+    if (!strcmp(mFitOption.Data(), "Chi2")) {
+      return mTotalPdf->chi2FitTo(dataHistogram, rangeName ? Range(rangeName) : RooCmdArg(), Save(), evalBackendArg(), strategyArg());
+    }
+    return mTotalPdf->fitTo(dataHistogram, rangeName ? Range(rangeName) : RooCmdArg(), Extended(), Save(), evalBackendArg(), strategyArg());
+  }
+
+  std::unique_ptr<RooAbsReal> fcn;
+  if (!strcmp(mFitOption.Data(), "Chi2")) {
+    fcn.reset(mTotalPdf->createChi2(dataHistogram, rangeName ? Range(rangeName) : RooCmdArg(), evalBackendArg()));
+  } else {
+    fcn.reset(mTotalPdf->createNLL(dataHistogram, rangeName ? Range(rangeName) : RooCmdArg(), Extended(), evalBackendArg()));
+  }
+  RooMinimizer minimizer(*fcn);
+  if (mFitStrategy >= 0) {
+    minimizer.setStrategy(mFitStrategy);
+  }
+  minimizer.migrad();
+  minimizer.hesse();
+  mFitNCalls += minimizer.evalCounter();
+  return minimizer.save();
+}
+
+std::map<std::string, Double_t> HFInvMassFitter::getFitParameters() const
+{
+  if (mTotalPdf == nullptr) {
+    throw std::runtime_error("HFInvMassFitter::getFitParameters(): mTotalPdf == nullptr, the fit is not done");
+  }
+  std::map<std::string, Double_t> result;
+  std::unique_ptr<RooArgSet> parameters{mTotalPdf->getParameters(RooArgSet(*mWorkspace->var("mass")))};
+  for (const auto* parameter : *parameters) {
+    const auto* var = dynamic_cast<const RooRealVar*>(parameter);
+    if (var != nullptr && !var->isConstant()) {
+      result.emplace(var->GetName(), var->getVal());
+    }
+  }
+  return result;
+}
+
+// RooFit evaluation backend of the fits, ROOT's default if not set
+RooCmdArg HFInvMassFitter::evalBackendArg() const
+{
+  return mEvalBackend.empty() ? RooCmdArg() : EvalBackend(mEvalBackend);
+}
+
+// MINUIT strategy of the fits, ROOT's default if not set
+RooCmdArg HFInvMassFitter::strategyArg() const
+{
+  return mFitStrategy < 0 ? RooCmdArg() : Strategy(mFitStrategy);
+}
+
+// chi2 / ndf of the pdf against the data over the histogram bins whose centres are within the given ranges of mass,
+// computed as RooPlot::chiSquare() does with the plotted curves (the pdf normalised to its expected number of events,
+// asymmetric Poisson errors of the data or the sum of weights' ones for the weighted data, empty bins skipped,
+// ndf is the number of the bins), but without plotting: the bin integrals of the pdf are evaluated with Simpson's rule
+Double_t HFInvMassFitter::computeChiSquareOverNdf(RooAbsPdf* pdf, const RooDataHist& dataHistogram, const std::vector<std::string>& rangeNames) const
+{
+  RooRealVar* mass = mWorkspace->var("mass");
+  const RooArgSet normSet(*mass);
+  const double massValue = mass->getVal();
+  const double nExpected = pdf->expectedEvents(normSet);
+  const bool isPoisson = !dataHistogram.isNonPoissonWeighted();
+  auto pdfValue = [&](double x) {
+    mass->setVal(x);
+    return pdf->getVal(normSet);
+  };
+
+  double chiSquare{0.};
+  int nBins{0};
+  for (int iBin = 1; iBin <= mHistoInvMass->GetNbinsX(); iBin++) {
+    const double binCenter = mHistoInvMass->GetBinCenter(iBin);
+    const double binLow = mHistoInvMass->GetBinLowEdge(iBin);
+    const double binUp = mHistoInvMass->GetBinLowEdge(iBin + 1);
+    const bool isInRange = std::any_of(rangeNames.begin(), rangeNames.end(), [&](const std::string& rangeName) {
+      return mass->inRange(binCenter, rangeName.c_str());
+    });
+    const double content = mHistoInvMass->GetBinContent(iBin);
+    if (!isInRange || binLow < mMinMass || binUp > mMaxMass || content == 0.) {
+      continue;
+    }
+    const double expected = nExpected * (binUp - binLow) * (pdfValue(binLow) + 4 * pdfValue(binCenter) + pdfValue(binUp)) / 6;
+    double errorLow = mHistoInvMass->GetBinError(iBin);
+    double errorUp = errorLow;
+    if (isPoisson) {
+      double lowerBound, upperBound;
+      RooHistError::instance().getPoissonInterval(static_cast<Int_t>(std::round(content)), lowerBound, upperBound, 1.);
+      errorLow = content - lowerBound;
+      errorUp = upperBound - content;
+    }
+    const double pull = (content - expected) / (content > expected ? errorLow : errorUp);
+    chiSquare += pull * pull;
+    nBins++;
+  }
+  mass->setVal(massValue);
+
+  return nBins > 0 ? chiSquare / nBins : 0.;
+}
+
+// Toy pseudo-experiments of the fitted model. The expected bin contents are evaluated once (the pdf normalised to its expected
+// number of events, Simpson's rule over the bins of the fitted histogram, as in computeChiSquareOverNdf()), each toy fluctuates
+// them and is fitted as the data of doFit(): the total pdf only, with the fitted parameters as the starting point.
+// RooFit is not thread-safe, so the toys are shared between forked processes, the toy iToy being run by the worker iToy % nWorkers,
+// which writes the results of its toys into a temporary binary file
+void HFInvMassFitter::doToys(Int_t nToys, ULong_t seed, Int_t nWorkers)
+{
+  if (mTotalPdf == nullptr) {
+    throw std::runtime_error("HFInvMassFitter::doToys(): mTotalPdf == nullptr, the fit is not done");
+  }
+  if (seed == 0) {
+    throw std::runtime_error("HFInvMassFitter::doToys(): the seed must be positive, TRandom3(0) is not reproducible");
+  }
+  nWorkers = std::max(std::min(nWorkers, nToys), 1);
+
+  RooRealVar* mass = mWorkspace->var("mass");
+  const RooArgSet normSet(*mass);
+  std::unique_ptr<RooArgSet> parameters{mTotalPdf->getParameters(normSet)};
+  std::unique_ptr<RooArgSet> fittedParameters{static_cast<RooArgSet*>(parameters->snapshot())};
+  auto resetParameters = [&]() {
+    for (auto* parameter : *parameters) {
+      auto* var = dynamic_cast<RooRealVar*>(parameter);
+      const auto* fittedVar = dynamic_cast<const RooRealVar*>(fittedParameters->find(parameter->GetName()));
+      if (var == nullptr || fittedVar == nullptr || var->isConstant()) {
+        continue;
+      }
+      var->setVal(fittedVar->getVal());
+      var->setError(fittedVar->getError());
+    }
+  };
+  const Double_t trueRawYield = mRooNSgn->getVal();
+  const Double_t trueMean = mRooMeanSgn->getVal();
+  const Double_t trueSigma = mRooSigmaSgn->getVal();
+  const char* rangeName = mTypeOfBkgPdf == NoBkg ? "full" : nullptr; // as in doFit()
+
+  std::unique_ptr<TH1> histoExpected{static_cast<TH1*>(mHistoInvMass->Clone("histoToyExpected"))};
+  histoExpected->SetDirectory(nullptr);
+  histoExpected->Reset();
+  const double massValue = mass->getVal();
+  const double nExpected = mTotalPdf->expectedEvents(normSet);
+  auto pdfValue = [&](double x) {
+    mass->setVal(x);
+    return mTotalPdf->getVal(normSet);
+  };
+  for (int iBin = 1; iBin <= histoExpected->GetNbinsX(); iBin++) {
+    const double binLow = histoExpected->GetBinLowEdge(iBin);
+    const double binUp = histoExpected->GetBinLowEdge(iBin + 1);
+    if (binLow < mMinMass || binUp > mMaxMass) {
+      continue;
+    }
+    histoExpected->SetBinContent(iBin, nExpected * (binUp - binLow) * (pdfValue(binLow) + 4 * pdfValue(histoExpected->GetBinCenter(iBin)) + pdfValue(binUp)) / 6);
+  }
+  mass->setVal(massValue);
+
+  // status, raw yield, its error, mean, its error, sigma, its error
+  using ToyResult = std::array<Double_t, 7>;
+  auto fitToy = [&](Int_t iToy) -> ToyResult {
+    TRandom3 random(seed + iToy);
+    std::unique_ptr<TH1> histoToy{static_cast<TH1*>(histoExpected->Clone("histoToy"))};
+    histoToy->SetDirectory(nullptr);
+    for (int iBin = 1; iBin <= histoToy->GetNbinsX(); iBin++) {
+      const double content = random.PoissonD(histoExpected->GetBinContent(iBin));
+      histoToy->SetBinContent(iBin, content);
+      histoToy->SetBinError(iBin, std::sqrt(content));
+    }
+    RooDataHist toyHistogram("toyHistogram", "toy", *mass, Import(*histoToy));
+    resetParameters();
+    std::unique_ptr<RooFitResult> result{minimizeTotalPdf(toyHistogram, rangeName)};
+    return {static_cast<Double_t>(result->status()), mRooNSgn->getVal(), mRooNSgn->getError(), mRooMeanSgn->getVal(), mRooMeanSgn->getError(), mRooSigmaSgn->getVal(), mRooSigmaSgn->getError()};
+  };
+
+  const Int_t fitNCalls = mFitNCalls;
+  std::vector<ToyResult> toyResults(nToys);
+  if (nWorkers == 1) {
+    for (Int_t iToy = 0; iToy < nToys; iToy++) {
+      toyResults.at(iToy) = fitToy(iToy);
+    }
+  } else {
+    const std::string toyFilePrefix = "HFInvMassFitter_" + std::to_string(getpid()) + "_toys";
+    auto toyFileName = [&toyFilePrefix](Int_t iWorker) {
+      return toyFilePrefix + std::to_string(iWorker) + ".bin";
+    };
+    fflush(stdout);
+    fflush(stderr);
+    for (Int_t iWorker = 0; iWorker < nWorkers; iWorker++) {
+      const pid_t pid = fork();
+      if (pid < 0) {
+        throw std::runtime_error("HFInvMassFitter::doToys(): fork() failed");
+      }
+      if (pid == 0) {
+        int status = 0;
+        try {
+          std::ofstream toyFile(toyFileName(iWorker), std::ios::binary);
+          for (Int_t iToy = iWorker; iToy < nToys; iToy += nWorkers) {
+            const ToyResult toyResult = fitToy(iToy);
+            toyFile.write(reinterpret_cast<const char*>(toyResult.data()), sizeof(ToyResult));
+          }
+          if (!toyFile) {
+            throw std::runtime_error("cannot write " + toyFileName(iWorker));
+          }
+        } catch (const std::exception& e) {
+          fprintf(stderr, "HFInvMassFitter::doToys(): worker %d failed: %s\n", iWorker, e.what());
+          status = 1;
+        }
+        fflush(stdout);
+        fflush(stderr);
+        _exit(status); // do not run the parent's atexit handlers, e.g. ROOT's cleanup
+      }
+    }
+    bool isFailed{false};
+    for (Int_t iWorker = 0; iWorker < nWorkers; iWorker++) {
+      int status;
+      const pid_t pid = wait(&status);
+      isFailed |= pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    for (Int_t iWorker = 0; iWorker < nWorkers; iWorker++) {
+      std::ifstream toyFile(toyFileName(iWorker), std::ios::binary);
+      for (Int_t iToy = iWorker; iToy < nToys && toyFile; iToy += nWorkers) {
+        toyFile.read(reinterpret_cast<char*>(toyResults.at(iToy).data()), sizeof(ToyResult));
+      }
+      isFailed |= !toyFile;
+      toyFile.close();
+      std::remove(toyFileName(iWorker).c_str());
+    }
+    if (isFailed) {
+      throw std::runtime_error("HFInvMassFitter::doToys(): a worker process failed");
+    }
+  }
+  mFitNCalls = fitNCalls;
+  resetParameters();
+
+  for (auto* histo : {mHistoToyPullRawYield, mHistoToyPullMean, mHistoToyPullSigma, mHistoToyRawYield}) {
+    delete histo;
+  }
+  const Double_t rawYieldRange = 5 * std::max(mRooNSgn->getError(), std::sqrt(std::abs(trueRawYield)));
+  mHistoToyPullRawYield = new TH1D("hToyPullRawYield", ";(#it{N}_{sig}^{toy} #minus #it{N}_{sig}^{fit}) / #sigma_{toy};toys", 100, -5., 5.);
+  mHistoToyPullMean = new TH1D("hToyPullMean", ";(#mu^{toy} #minus #mu^{fit}) / #sigma_{toy};toys", 100, -5., 5.);
+  mHistoToyPullSigma = new TH1D("hToyPullSigma", ";(#sigma^{toy} #minus #sigma^{fit}) / #sigma_{toy};toys", 100, -5., 5.);
+  mHistoToyRawYield = new TH1D("hToyRawYield", ";#it{N}_{sig}^{toy};toys", 100, trueRawYield - rawYieldRange, trueRawYield + rawYieldRange);
+  for (auto* histo : {mHistoToyPullRawYield, mHistoToyPullMean, mHistoToyPullSigma, mHistoToyRawYield}) {
+    histo->SetDirectory(nullptr);
+  }
+  mToyNFailed = 0;
+  for (const auto& [status, rawYield, rawYieldErr, mean, meanErr, sigma, sigmaErr] : toyResults) {
+    if (status != 0 || rawYieldErr <= 0 || meanErr <= 0 || sigmaErr <= 0) {
+      ++mToyNFailed;
+      continue;
+    }
+    mHistoToyPullRawYield->Fill((rawYield - trueRawYield) / rawYieldErr);
+    mHistoToyPullMean->Fill((mean - trueMean) / meanErr);
+    mHistoToyPullSigma->Fill((sigma - trueSigma) / sigmaErr);
+    mHistoToyRawYield->Fill(rawYield);
+  }
+}
+
+void HFInvMassFitter::checkNotHeadless(const std::string& method) const
+{
+  if (mHeadless) {
+    throw std::runtime_error("HFInvMassFitter::" + method + "(): nothing to draw, the fit is done in the headless mode");
+  }
+}
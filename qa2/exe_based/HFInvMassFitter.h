@@ -22,6 +22,7 @@
 #define PWGHF_D2H_MACROS_HFINVMASSFITTER_H_
 
 #include <RooAddPdf.h>
+#include <RooDataHist.h>
 #include <RooFitResult.h>
 #include <RooFormulaVar.h>
 #include <RooPlot.h>
@@ -37,6 +38,7 @@
 #include <RtypesCore.h>
 
 #include <cstdio>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -86,6 +88,13 @@ class HFInvMassFitter : public TNamed
   void setUseLikelihoodFit() { mFitOption = "L,E"; }
   void setUseChi2Fit() { mFitOption = "Chi2"; }
   void setFitOption(TString opt) { mFitOption = opt.Data(); }
+  /// RooFit evaluation backend of the likelihood / chi2: "legacy", "cpu" (vectorised), "cuda" or "codegen"; ROOT's default if empty.
+  /// Requires ROOT >= 6.30 (>= 6.32 for the chi2 fit)
+  void setEvalBackend(const std::string& evalBackend) { mEvalBackend = evalBackend; }
+  /// MINUIT strategy (0 - fast, 1 - default, 2 - precise); ROOT's default if negative
+  void setFitStrategy(Int_t strategy) { mFitStrategy = strategy; }
+  /// Directory of the on-disk cache of the total fit results; on a hit the minimisation is skipped. Disabled if empty
+  void setFitCacheDirectory(const std::string& directory) { mFitCacheDirectory = directory; }
   RooAbsPdf* createBackgroundFitFunction(RooWorkspace* w1) const;
   RooAbsPdf* createSignalFitFunction(RooWorkspace* w1);
   RooAbsPdf* createReflectionFitFunction(RooWorkspace* w1) const;
@@ -215,11 +224,20 @@ class HFInvMassFitter : public TNamed
       mEnableReflections = kFALSE;
     }
     mHistoTemplateRefl = static_cast<TH1*>(histoRefl->Clone("mHistoTemplateRefl"));
+    mHistoTemplateRefl->SetDirectory(nullptr); // owned by the fitter, not by the current file
+  }
+  /// nSmooth TH1::Smooth() iterations are applied once to the template tabulated by its pdf (see TemplatePdf), not to the histogram
+  void setTemplateCorrelBg(TH1* histoCorrelBg, Int_t nSmooth = 0)
+  {
+    mHistoTemplateCorrelBg = histoCorrelBg;
+    mCorrelBgNSmooth = nSmooth;
   }
-  void setTemplateCorrelBg(TH1* histoCorrelBg) { mHistoTemplateCorrelBg = histoCorrelBg; }
   void setDrawBgPrefit(Bool_t value = true) { mDrawBgPrefit = value; }
   void setDrawCorrelBg(Bool_t value = true) { mDrawCorrelBg = value; }
   void setHighlightPeakRegion(Bool_t value = true) { mHighlightPeakRegion = value; }
+  /// no RooPlot frames are created in doFit(): the chi2 values are computed directly from the pdfs and the histogram,
+  /// and drawFit(), drawResidual() and drawReflection() are not available
+  void setHeadless(Bool_t value = true) { mHeadless = value; }
   Double_t getChiSquareOverNDFTotal() const { return mChiSquareOverNdfTotal; }
   Double_t getChiSquareOverNDFBkg() const { return mChiSquareOverNdfBkg; }
   Double_t getRawYield() const { return mRawYield; }
@@ -264,7 +282,29 @@ class HFInvMassFitter : public TNamed
   void drawResidual(TVirtualPad* c);
   void drawReflection(TVirtualPad* c);
   void setRandomSeed(ULong_t seed) { mRandomSeed = seed; }
+  /// starting values of the total fit by parameter name, e.g. the converged ones of a similar spectrum (warm start);
+  /// they override the default initial values, unknown and fixed parameters are skipped.
+  /// If the fit from them does not converge, it is repeated from the default initial values
+  void setWarmStartParameters(const std::map<std::string, Double_t>& parameters) { mWarmStartParameters = parameters; }
+  /// warm-start mode: the total fit is minimised with RooMinimizer directly, which counts the function calls (getFitNCalls());
+  /// otherwise it is done with fitTo() / chi2FitTo() and getFitNCalls() is 0
+  void setWarmStart(Bool_t isWarmStart) { mIsWarmStart = isWarmStart; }
+  std::map<std::string, Double_t> getFitParameters() const;
+  Int_t getFitStatus() const { return mFitStatus; }
+  Int_t getFitNCalls() const { return mFitNCalls; }
+  Bool_t isWarmStartFallback() const { return mIsWarmStartFallback; }
   double randomizeInitialFitParameter(double valueLower, double valueUpper, double valueInitial, double valueSmear) const;
+  /// toy pseudo-experiments of the fitted model, to be called after doFit(): each toy is the histogram of the expected bin
+  /// contents of the fitted total pdf, Poisson-fluctuated bin by bin, and is fitted with the same pdf and fit options
+  /// starting from the fitted values (which are the true ones of the toys). The toy iToy is generated with TRandom3(seed + iToy),
+  /// so the results do not depend on nWorkers, the number of forked processes the toys are shared between.
+  /// The pulls of the raw yield, mean and sigma of the converged toys are filled into the getToy*() histograms
+  void doToys(Int_t nToys, ULong_t seed, Int_t nWorkers = 1);
+  TH1* getToyPullRawYield() const { return mHistoToyPullRawYield; }
+  TH1* getToyPullMean() const { return mHistoToyPullMean; }
+  TH1* getToyPullSigma() const { return mHistoToyPullSigma; }
+  TH1* getToyRawYield() const { return mHistoToyRawYield; }
+  Int_t getToyNFailed() const { return mToyNFailed; }
 
  private:
   HFInvMassFitter(const HFInvMassFitter& source);
@@ -274,6 +314,12 @@ class HFInvMassFitter : public TNamed
   void writeBgFitInfo(TH1* hM, const bool isPreFit) const;
   std::pair<Double_t, Double_t> getRangesOfSignal() const;
   static RooAbsPdf* getPdfByName(const RooAbsPdf* pdfIn, const std::string& name);
+  RooFitResult* fitTotalPdf(RooDataHist& dataHistogram, const char* rangeName = nullptr);
+  RooFitResult* minimizeTotalPdf(RooDataHist& dataHistogram, const char* rangeName);
+  RooCmdArg evalBackendArg() const;
+  RooCmdArg strategyArg() const;
+  Double_t computeChiSquareOverNdf(RooAbsPdf* pdf, const RooDataHist& dataHistogram, const std::vector<std::string>& rangeNames) const;
+  void checkNotHeadless(const std::string& method) const;
 
   TH1* mHistoInvMass; // histogram to fit
   TString mFitOption;
@@ -360,13 +406,28 @@ class HFInvMassFitter : public TNamed
   Double_t mIntegralBkg;       /// integral of background fit function
   TH1* mHistoTemplateRefl;     /// reflection histogram
   TH1* mHistoTemplateCorrelBg; /// correlated background histogram
+  Int_t mCorrelBgNSmooth;      /// smoothing of the correlated background template
   Bool_t mDrawBgPrefit;        /// draw background after fitting the sidebands
   Bool_t mDrawCorrelBg;        /// draw correlated background (if any)
   Bool_t mHighlightPeakRegion; /// draw vertical lines showing the peak region (usually +- 3 sigma)
   TRandom3* mRandomGen;
   Int_t mRandomSeed;
+  std::map<std::string, Double_t> mWarmStartParameters; /// starting values of the total fit
+  Bool_t mIsWarmStart;                                  /// warm-start mode, the total fit counts the function calls
+  Int_t mFitStatus;                                     /// status of the total fit
+  Int_t mFitNCalls;                                     /// number of function calls of the total fit, incl. the fallback one (warm-start mode only)
+  Bool_t mIsWarmStartFallback;                          /// the fit from the warm-start parameters failed and was repeated
+  std::string mEvalBackend;                             /// RooFit evaluation backend, ROOT's default if empty
+  Int_t mFitStrategy;                                   /// MINUIT strategy, ROOT's default if negative
+  std::string mFitCacheDirectory;                       /// directory of the fit results' cache, disabled if empty
+  Bool_t mHeadless;                                     /// no RooPlot frames, chi2 computed directly
+  TH1* mHistoToyPullRawYield;                           /// pulls of the raw yield in the toys
+  TH1* mHistoToyPullMean;                               /// pulls of the mean in the toys
+  TH1* mHistoToyPullSigma;                              /// pulls of the sigma in the toys
+  TH1* mHistoToyRawYield;                               /// raw yields of the toys
+  Int_t mToyNFailed;                                    /// number of the toys whose fit did not converge
 
-  ClassDef(HFInvMassFitter, 1);
+  ClassDef(HFInvMassFitter, 7);
 };
 
 #endif // PWGHF_D2H_MACROS_HFINVMASSFITTER_H_
@@ -6,5 +6,6 @@
 #pragma link off all typedef;
 
 #pragma link C++ class HFInvMassFitter+;
+#pragma link C++ class TemplatePdf+;
 
 #endif
\ No newline at end of file
@@ -140,17 +140,11 @@ void HelperGeneral::CheckTAxisForRanges(const TAxis& axis, const std::vector<dou
   }
 }
 
-void HelperGeneral::SetTHnSparseAxisRanges(THnSparse* histo, int axisNum, float lo, float hi) {
+std::pair<int, int> HelperGeneral::FindTAxisBinRange(const TAxis* axis, float lo, float hi) {
   constexpr double tolerance = 1e-6;
 
-  if(std::fabs(lo+999)<tolerance && std::fabs(hi+999)<tolerance) {
-    histo->GetAxis(axisNum)->SetRange();
-    return;
-  }
-
-  if(lo >= hi) throw std::runtime_error("SetTHnSparseAxisRanges(): lo >= hi");
+  if(lo >= hi) throw std::runtime_error("FindTAxisBinRange(): lo >= hi");
 
-  const TAxis* axis = histo->GetAxis(axisNum);
   int binLo{-999}, binHi{-999};
   for(int iBin=1, nBins=axis->GetNbins(); iBin<=nBins; ++iBin) {
     const float binLowEdge = axis->GetBinLowEdge(iBin);
@@ -159,7 +153,20 @@ void HelperGeneral::SetTHnSparseAxisRanges(THnSparse* histo, int axisNum, float
     if(std::fabs(binUpEdge - hi)<tolerance) binHi = iBin;
     if(binLo != -999 && binHi != -999) break;
   }
-  if(binLo == -999 || binHi == -999) throw std::runtime_error("SetTHnSparseAxisRanges(): binLo == -999 || binHi == -999");
+  if(binLo == -999 || binHi == -999) throw std::runtime_error("FindTAxisBinRange(): binLo == -999 || binHi == -999");
+
+  return std::make_pair(binLo, binHi);
+}
+
+void HelperGeneral::SetTHnSparseAxisRanges(THnSparse* histo, int axisNum, float lo, float hi) {
+  constexpr double tolerance = 1e-6;
+
+  if(std::fabs(lo+999)<tolerance && std::fabs(hi+999)<tolerance) {
+    histo->GetAxis(axisNum)->SetRange();
+    return;
+  }
+
+  const auto [binLo, binHi] = FindTAxisBinRange(histo->GetAxis(axisNum), lo, hi);
   histo->GetAxis(axisNum)->SetRange(binLo, binHi);
 }
 
@@ -171,6 +178,16 @@ double HelperGeneral::InterpolateTH1SuppressWarning(const TH1* h, double value)
   return result;
 }
 
+std::vector<double> HelperGeneral::EvaluateWeightLookupTable(const TAxis* axis, const TH1* histoWeight) {
+  // weight at the center of each axis bin, incl. under- and overflow
+  const int nBins = axis->GetNbins();
+  std::vector<double> result(nBins + 2);
+  for(int iBin=0; iBin<=nBins+1; ++iBin) {
+    result.at(iBin) = InterpolateTH1SuppressWarning(histoWeight, axis->GetBinCenter(iBin));
+  }
+  return result;
+}
+
 void HelperGeneral::ScaleTHnSparseWithWeight(THnSparse* histoIn, int nDim, const TH1* histoWeight) {
   const int nDims = histoIn->GetNdimensions();
   if(nDims <= nDim) {
@@ -178,6 +195,9 @@ void HelperGeneral::ScaleTHnSparseWithWeight(THnSparse* histoIn, int nDim, const
   }
   histoIn->Sumw2();
 
+  // The weight depends only on the bin along nDim axis - evaluate it once per axis bin
+  const std::vector<double> scaleFactors = EvaluateWeightLookupTable(histoIn->GetAxis(nDim), histoWeight);
+
   // Buffers for coordinates
   // coords[i] will hold bin index along axis i
   std::vector<int> coords(nDims);
@@ -188,18 +208,9 @@ void HelperGeneral::ScaleTHnSparseWithWeight(THnSparse* histoIn, int nDim, const
     const double content = histoIn->GetBinContent(iBin, coords.data());
     if (content == 0) continue;
 
-    const int binIndex = coords.at(nDim);  // Note: this is the bin number along that axis
-    const TAxis* axis = histoIn->GetAxis(nDim);
-    const double binCenter = axis->GetBinCenter(binIndex);
-
-    const double scaleFactor = InterpolateTH1SuppressWarning(histoWeight, binCenter);
-
-    const double newContent = content * scaleFactor;
-    histoIn->SetBinContent(coords.data(), newContent);
-
-    const double err = histoIn->GetBinError(iBin);
-    const double newErr = err * scaleFactor;
-    histoIn->SetBinError(coords.data(), newErr);
+    const double scaleFactor = scaleFactors[coords[nDim]];
+    histoIn->SetBinContent(iBin, content * scaleFactor);
+    histoIn->SetBinError2(iBin, histoIn->GetBinError2(iBin) * scaleFactor * scaleFactor);
   }
 }
 
@@ -222,6 +233,29 @@ std::string HelperGeneral::ReadNthLine(const std::string& fileName) {
   return result;
 }
 
+std::string HelperGeneral::ExtractStringOption(int& argc, char* argv[], const std::string& option, const std::string& defaultValue) {
+  for(int iArg=1; iArg<argc; ++iArg) {
+    if(option != argv[iArg]) continue;
+    if(iArg + 1 >= argc) throw std::runtime_error("HelperGeneral::ExtractStringOption() - the value of option " + option + " is missing");
+    const std::string result = argv[iArg + 1];
+    for(int jArg=iArg; jArg+2<=argc; ++jArg) {
+      argv[jArg] = argv[jArg + 2];
+    }
+    argc -= 2;
+    return result;
+  }
+  return defaultValue;
+}
+
+int HelperGeneral::ExtractIntOption(int& argc, char* argv[], const std::string& option, int defaultValue) {
+  const std::string value = ExtractStringOption(argc, argv, option, std::to_string(defaultValue));
+  try {
+    return std::stoi(value);
+  } catch(const std::logic_error&) {
+    throw std::runtime_error("HelperGeneral::ExtractIntOption() - the value " + value + " of option " + option + " is not an integer");
+  }
+}
+
 void HelperGeneral::MkDirBash(const std::string& dirName) {
   const auto status = std::system(("mkdir -p " + dirName).c_str());
   if(status != 0) {
@@ -79,14 +79,24 @@ std::map<std::string_view, int> MapTHnSparseAxesIndices(const THnSparse* histo);
 
 void CheckTAxisForRanges(const TAxis& axis, const std::vector<double>& ranges);
 
+std::pair<int, int> FindTAxisBinRange(const TAxis* axis, float lo, float hi);
+
 void SetTHnSparseAxisRanges(THnSparse* histo, int axisNum, float lo= -999., float hi= -999.);
 
 double InterpolateTH1SuppressWarning(const TH1* h, double value);
 
+std::vector<double> EvaluateWeightLookupTable(const TAxis* axis, const TH1* histoWeight);
+
 void ScaleTHnSparseWithWeight(THnSparse* histoIn, int nDim, const TH1* histoWeight);
 
 std::string ReadNthLine(const std::string& fileName);
 
+/// Finds "option value" among the command line arguments, removes both from argv and returns the value
+/// (or defaultValue if the option is absent), so that the positional arguments keep their numbering
+int ExtractIntOption(int& argc, char* argv[], const std::string& option, int defaultValue);
+
+std::string ExtractStringOption(int& argc, char* argv[], const std::string& option, const std::string& defaultValue);
+
 void MkDirBash(const std::string& dirName);
 };
 
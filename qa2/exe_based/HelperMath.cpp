@@ -8,9 +8,42 @@
 
 #include <TF1.h>
 #include <TH1.h>
+#include <TH1D.h>
 #include <TMatrixD.h>
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
+#include <vector>
+
+namespace {
+/// The contents and the sums of weights squared of a plain 1D TH1D are contiguous arrays of GetNcells() cells
+/// (incl. under- and overflow), so the kernels below read and write them directly in vectorisable loops instead of
+/// the virtual Get/SetBinContent() and Get/SetBinError() per bin. Any other histogram (TH1F, TProfile whose contents
+/// are derived, non-normal bin errors, unflushed buffer, no Sumw2 where the errors are written) takes the generic path.
+/// The kernels repeat the arithmetic of the generic path exactly (e.g. the sum of weights squared is the square of the
+/// error set by SetBinError()), so that both give the same bits, see tests/test_helper_math_fast_paths.cpp
+bool isUseFastPaths{true};
+
+bool IsPlainTH1D(const TH1* histo, bool isSumw2Required=true) {
+  return isUseFastPaths && histo != nullptr && histo->IsA() == TH1D::Class() && histo->GetBinErrorOption() == TH1::kNormal &&
+         histo->GetBuffer() == nullptr && (!isSumw2Required || histo->GetSumw2N() > 0);
+}
+
+double* Contents(TH1* histo) { return static_cast<TH1D*>(histo)->GetArray(); }
+const double* Contents(const TH1* histo) { return static_cast<const TH1D*>(histo)->GetArray(); }
+double* Sumw2(TH1* histo) { return histo->GetSumw2()->GetArray(); }
+const double* Sumw2(const TH1* histo) { return histo->GetSumw2()->GetArray(); }
+
+/// What SetBinContent() does to the statistics of a histogram besides setting the content:
+/// the entries are incremented, and the sums of weights are reset, so that they are recomputed from the bins
+void MarkBinsSet(TH1* histo, int nSetBins) {
+  const double entries = histo->GetEntries() + nSetBins;
+  double stats[TH1::kNstat]{};
+  histo->PutStats(stats);
+  histo->SetEntries(entries);
+}
+}
 
 std::pair<double, double> HelperMath::EstimateExpoParameters(TH1* h) {
   int ilo{1};
@@ -128,6 +161,26 @@ void HelperMath::DivideHistoByFunction(TH1* histo, TF1* func, const std::string&
 
 void HelperMath::EvalNormDifferenceHistoFromFunction(TH1* histo, TF1* func, const std::string& option) {
   const bool isIntegral = option == "I" ? true : option.empty() ? false : throw std::runtime_error("HelperMath::EvalNormDifferenceHistoFromFunction() - 'option' must be either empty string or I");
+  if(IsPlainTH1D(histo) && !histo->GetXaxis()->IsVariableBinSize()) {
+    const int nBins = histo->GetNbinsX();
+    const double xMin = histo->GetXaxis()->GetXmin();
+    const double binWidth = (histo->GetXaxis()->GetXmax() - xMin) / nBins;
+    std::vector<double> funcValues(nBins + 2, 0.);
+    for(int iBin=1; iBin<=nBins; iBin++) {
+      const double lo = xMin + (iBin-1)*binWidth;
+      const double hi = xMin + iBin*binWidth;
+      funcValues[iBin] = isIntegral ? func->Integral(lo, hi) / (hi-lo) : func->Eval(lo + 0.5*binWidth); // as TAxis::GetBinCenter()
+    }
+    double* contents = Contents(histo);
+    double* sumw2 = Sumw2(histo);
+    for(int iBin=1; iBin<=nBins; iBin++) {
+      const double histoError = std::sqrt(sumw2[iBin]);
+      contents[iBin] = histoError != 0. ? (contents[iBin] - funcValues[iBin]) / histoError : 0.;
+      sumw2[iBin] = histoError != 0. ? 1e-9 * 1e-9 : 0.;
+    }
+    MarkBinsSet(histo, nBins);
+    return;
+  }
   for(int iBin=1, nBins=histo->GetNbinsX(); iBin<=nBins; iBin++) {
     const double histoValue = histo->GetBinContent(iBin);
     const double histoError = histo->GetBinError(iBin);
@@ -142,6 +195,19 @@ void HelperMath::EvalNormDifferenceHistoFromFunction(TH1* histo, TF1* func, cons
 
 void HelperMath::InvertHisto(TH1* histo) {
   Sumw2IfNotYet(histo);
+  if(IsPlainTH1D(histo)) {
+    const int nBins = histo->GetNbinsX();
+    double* contents = Contents(histo);
+    double* sumw2 = Sumw2(histo);
+    for(int iBin=1; iBin<nBins; ++iBin) {
+      const double value = contents[iBin];
+      const double error = std::sqrt(sumw2[iBin]) / value / value;
+      contents[iBin] = 1./value;
+      sumw2[iBin] = error * error;
+    }
+    MarkBinsSet(histo, std::max(nBins-1, 0));
+    return;
+  }
   for(int iBin=1, nBins=histo->GetNbinsX(); iBin<nBins; ++iBin) {
     const double value = histo->GetBinContent(iBin);
     const double error = histo->GetBinError(iBin);
@@ -178,7 +244,30 @@ std::pair<TH1*, TH1*> HelperMath::EvaluateEfficiencyHisto(TH1* hNum, TH1* hDen)
       return 1. / 2. / relErr * std::sqrt(1. / num / num / num + 1. / den / den / den - 2. / num / den / den);
   };
 
-  for (int iBin = 1; iBin <= nBins; iBin++) {
+  const bool isPlain = IsPlainTH1D(hNum, false) && IsPlainTH1D(hDen, false) && IsPlainTH1D(hEff) && IsPlainTH1D(hRelErr);
+  if (isPlain) {
+    const double* nums = Contents(hNum);
+    const double* dens = Contents(hDen);
+    double* effs = Contents(hEff);
+    double* effSumw2 = Sumw2(hEff);
+    double* relErrs = Contents(hRelErr);
+    double* relErrSumw2 = Sumw2(hRelErr);
+    for (int iBin = 1; iBin <= nBins; iBin++) {
+      const double num = nums[iBin];
+      const double den = dens[iBin];
+      const double eff = EvalEfficiency(num, den);
+      const double relErr = EvalRelErrOfEfficiency(num, den);
+      const double absErrOnRelErr = EvalAbsErrOfRelErrOfEfficiency(num, den);
+      const double effErr = eff * relErr;
+      effs[iBin] = eff;
+      effSumw2[iBin] = effErr * effErr;
+      relErrs[iBin] = relErr;
+      relErrSumw2[iBin] = absErrOnRelErr * absErrOnRelErr;
+    }
+    MarkBinsSet(hEff, nBins);
+    MarkBinsSet(hRelErr, nBins);
+  }
+  for (int iBin = 1; iBin <= nBins && !isPlain; iBin++) {
     const double num = hNum->GetBinContent(iBin);
     const double den = hDen->GetBinContent(iBin);
     const double eff = EvalEfficiency(num, den);
@@ -209,8 +298,67 @@ TH1* HelperMath::MergeHistograms(const std::vector<TH1*>& histos) {
   TH1* hResult = dynamic_cast<TH1*>(histos.at(0)->Clone("hMerged"));
   Sumw2IfNotYet(hResult);
   hResult->SetDirectory(nullptr);
-  for(size_t iH=1, nHs=histos.size(); iH<nHs; ++iH) {
-    hResult->Add(histos.at(iH));
+  // TH1::Add() with c1 = 1 of plain histograms: the cells and the statistics are summed,
+  // the squared error of an addend without Sumw2 is its content (TH1::GetBinErrorSqUnchecked()).
+  // The cells are summed by index, hence only for the addends with exactly the same x axis as the first one;
+  // the ones that only pass the tolerance of CheckHistogramsForXaxisIdentity() are left to TH1::Add() and its consistency checks
+  auto IsSameXaxis = [&](const TH1* h) {
+    const TAxis* axis = h->GetXaxis();
+    const TAxis* axisResult = hResult->GetXaxis();
+    if(h->GetNcells() != hResult->GetNcells() || axis->GetNbins() != axisResult->GetNbins() ||
+       axis->GetXmin() != axisResult->GetXmin() || axis->GetXmax() != axisResult->GetXmax()) return false;
+    const TArrayD* bins = axis->GetXbins();
+    const TArrayD* binsResult = axisResult->GetXbins();
+    if(bins->GetSize() != binsResult->GetSize()) return false;
+    return std::equal(bins->GetArray(), bins->GetArray() + bins->GetSize(), binsResult->GetArray());
+  };
+  auto IsPlainAddend = [&](const TH1* h) {
+    return IsPlainTH1D(h, false) && h->GetNormFactor() == 0. && !h->TestBit(TH1::kIsAverage) && h->GetXaxis()->GetLabels() == nullptr &&
+           IsSameXaxis(h);
+  };
+  bool isPlain = IsPlainAddend(hResult);
+  for(const auto& h : histos) {
+    isPlain &= IsPlainAddend(h);
+  }
+  if(isPlain) {
+    const int nCells = hResult->GetNcells();
+    double* contents = Contents(hResult);
+    double* sumw2 = Sumw2(hResult);
+    double entries = hResult->GetEntries();
+    double stats[TH1::kNstat]{};
+    hResult->GetStats(stats);
+    for(size_t iH=1, nHs=histos.size(); iH<nHs; ++iH) {
+      const TH1* h = histos.at(iH);
+      const double* hContents = Contents(h);
+      if(h->GetSumw2N() > 0) {
+        const double* hSumw2 = Sumw2(h);
+        for(int iCell=0; iCell<nCells; ++iCell) {
+          contents[iCell] += hContents[iCell];
+          sumw2[iCell] += hSumw2[iCell];
+        }
+      } else {
+        for(int iCell=0; iCell<nCells; ++iCell) {
+          contents[iCell] += hContents[iCell];
+          sumw2[iCell] += hContents[iCell];
+        }
+      }
+      double hStats[TH1::kNstat]{};
+      h->GetStats(hStats);
+      for(int iStat=0; iStat<TH1::kNstat; ++iStat) {
+        stats[iStat] += hStats[iStat];
+      }
+      entries = std::fabs(entries + h->GetEntries());
+    }
+    if(histos.size() > 1) { // what TH1::Add() does besides the cells
+      hResult->PutStats(stats);
+      hResult->SetEntries(entries);
+      hResult->SetMinimum();
+      hResult->SetMaximum();
+    }
+  } else {
+    for(size_t iH=1, nHs=histos.size(); iH<nHs; ++iH) {
+      hResult->Add(histos.at(iH));
+    }
   }
   Sumw2IfNotYet(hResult, isSumw2);
 
@@ -270,6 +418,30 @@ TH1* HelperMath::CutSubHistogram(const TH1* histoIn, double lo, double hi) {
   histoOut->GetYaxis()->SetTitle(histoIn->GetYaxis()->GetTitle());
   histoOut->SetName(histoIn->GetName());
   histoOut->SetTitle(histoIn->GetTitle());
+  if(IsPlainTH1D(histoIn, false)) {
+    // the generic path ends up with Sumw2 too, as SetBinError() enables it
+    Sumw2IfNotYet(histoOut);
+    const int nBins = binEdges.size()-1;
+    const double* contentsIn = Contents(histoIn) + binLoIn-1;
+    double* contentsOut = Contents(histoOut);
+    double* sumw2Out = Sumw2(histoOut);
+    if(histoIn->GetSumw2N() > 0) {
+      const double* sumw2In = Sumw2(histoIn) + binLoIn-1;
+      for(int iBin=1; iBin<=nBins; ++iBin) {
+        const double error = std::sqrt(sumw2In[iBin]);
+        contentsOut[iBin] = contentsIn[iBin];
+        sumw2Out[iBin] = error * error;
+      }
+    } else {
+      for(int iBin=1; iBin<=nBins; ++iBin) {
+        const double error = std::sqrt(std::fabs(contentsIn[iBin]));
+        contentsOut[iBin] = contentsIn[iBin];
+        sumw2Out[iBin] = error * error;
+      }
+    }
+    MarkBinsSet(histoOut, nBins);
+    return histoOut;
+  }
   for(int iBin=1, nBins=binEdges.size()-1; iBin<=nBins; ++iBin) {
     const double value = histoIn->GetBinContent(binLoIn-1 + iBin);
     const double error = histoIn->GetBinError(binLoIn-1 + iBin);
@@ -280,6 +452,10 @@ TH1* HelperMath::CutSubHistogram(const TH1* histoIn, double lo, double hi) {
   return histoOut;
 }
 
+void HelperMath::SetUseFastPaths(bool value) {
+  isUseFastPaths = value;
+}
+
 void HelperMath::Sumw2IfNotYet(TH1* histo, bool value) {
   const bool isSumw2Already = histo->GetSumw2N() > 0;
   if (isSumw2Already != value) histo->Sumw2(value);
@@ -76,6 +76,10 @@ TH1* CutSubHistogram(const TH1* histoIn, double lo, double hi);
 double EvalErrorFitFunction(double x, TF1* func, const TMatrixDSym& cov);
 
 void Sumw2IfNotYet(TH1* histo, bool value = true);
+
+/// The operations on plain TH1D histograms write their arrays directly (enabled by default);
+/// disabled, they take the generic per-bin TH1 calls, e.g. to compare the two
+void SetUseFastPaths(bool value);
 };
 
 
@@ -0,0 +1,64 @@
+#include "OutputSink.hpp"
+
+#include "HelperGeneral.hpp"
+
+#include <TH1.h>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+OutputSink::OutputSink(TFile* file, size_t maxBufferedBytes) : file_(file), max_buffered_bytes_(maxBufferedBytes) {
+  if(file == nullptr) throw std::runtime_error("OutputSink::OutputSink(): file == nullptr");
+}
+
+OutputSink::~OutputSink() {
+  if(file_ == nullptr) return;
+  // an exception must not escape the destructor (e.g. during the stack unwinding); the entries not written are reported
+  try {
+    Flush();
+  } catch(const std::exception& e) {
+    std::cout << "OutputSink::~OutputSink(): " << entries_.size() << " buffered object(s) are lost: " << e.what() << "\n";
+  }
+}
+
+void OutputSink::Add(const std::string& dirName, TObject* obj, const std::string& name) {
+  if(obj == nullptr) throw std::runtime_error("OutputSink::Add(): obj == nullptr for " + dirName + "/" + name);
+  if(auto histo = dynamic_cast<TH1*>(obj)) histo->SetDirectory(nullptr);
+
+  buffered_bytes_ += EstimateSize(obj);
+  entries_.push_back({dirName, name, std::unique_ptr<TObject>(obj)});
+  if(buffered_bytes_ > max_buffered_bytes_) Flush();
+}
+
+void OutputSink::Flush() {
+  if(entries_.empty()) return;
+
+  // the stable sort keeps the order of writing within a directory, so that the keys of a directory appear
+  // in the file in the same order as with the immediate writing
+  std::stable_sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+    return a.dir_name_ < b.dir_name_;
+  });
+
+  TDirectory* dirBefore = gDirectory;
+  const int compressionSettingsBefore = file_->GetCompressionSettings();
+  if(compression_settings_ >= 0) file_->SetCompressionSettings(compression_settings_);
+  for(size_t iEntry=0, nEntries=entries_.size(); iEntry<nEntries; ++iEntry) {
+    const auto& entry = entries_.at(iEntry);
+    if(iEntry == 0 || entry.dir_name_ != entries_.at(iEntry-1).dir_name_) HelperGeneral::CD(file_, entry.dir_name_);
+    entry.obj_->Write(entry.name_.c_str());
+  }
+  file_->SetCompressionSettings(compressionSettingsBefore);
+  if(dirBefore != nullptr) dirBefore->cd();
+
+  entries_.clear();
+  buffered_bytes_ = 0;
+}
+
+size_t OutputSink::EstimateSize(const TObject* obj) {
+  auto histo = dynamic_cast<const TH1*>(obj);
+  if(histo == nullptr) return sizeof(TObject);
+
+  const size_t nArrays = 1 + (histo->GetSumw2N() > 0 ? 1 : 0);
+  return sizeof(TH1) + nArrays * histo->GetNcells() * sizeof(double);
+}
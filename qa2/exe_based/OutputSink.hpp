@@ -0,0 +1,54 @@
+#ifndef QA2_OUTPUTSINK_HPP
+#define QA2_OUTPUTSINK_HPP
+
+#include <TFile.h>
+#include <TObject.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/// Buffered writer of many small objects into a TFile.
+/// Instead of HelperGeneral::CD() + Write() for each object, the (directory, name, object) triplets are collected
+/// in memory and written in one pass sorted by the directory path (the objects of a directory keep the order of their
+/// Add()-ing), so that each directory is created and entered only once, and a parent before its subdirectories.
+/// The pass is triggered by Flush(), by the destructor, or automatically when the buffered objects exceed
+/// the memory threshold. The resulting file layout is the same as of the immediate writing.
+class OutputSink {
+ public:
+  OutputSink() = delete;
+  /// The file is not owned by the sink and must stay open until the last Flush()
+  explicit OutputSink(TFile* file, size_t maxBufferedBytes=512*1024*1024);
+  OutputSink(const OutputSink&) = delete;
+  OutputSink& operator=(const OutputSink&) = delete;
+  OutputSink(OutputSink&&) = default;
+  OutputSink& operator=(OutputSink&&) = default;
+  /// Flushes the remaining entries; a failure is reported, not thrown
+  virtual ~OutputSink();
+
+  /// Takes the ownership of obj, which will be written into dirName with the key name
+  void Add(const std::string& dirName, TObject* obj, const std::string& name);
+
+  void Flush();
+
+  /// Compression of the objects written by the sink (ROOT::RCompressionSetting, e.g. 505 for ZSTD level 5);
+  /// by default the file's own setting is used. The file's setting is restored after each Flush()
+  void SetCompressionSettings(int settings) { compression_settings_ = settings; }
+
+ private:
+  struct Entry {
+    std::string dir_name_;
+    std::string name_;
+    std::unique_ptr<TObject> obj_;
+  };
+
+  static size_t EstimateSize(const TObject* obj);
+
+  TFile* file_{nullptr};
+  std::vector<Entry> entries_{};
+  size_t buffered_bytes_{0};
+  size_t max_buffered_bytes_{0};
+  int compression_settings_{-1};
+};
+
+#endif //QA2_OUTPUTSINK_HPP
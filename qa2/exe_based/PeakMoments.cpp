@@ -0,0 +1,102 @@
+#include "PeakMoments.hpp"
+
+#include <TMath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+PeakMoments PeakMoments::Estimate(const TH1* histo, double xMin, double xMax, double sideBandFraction) {
+  if(histo == nullptr) throw std::runtime_error("PeakMoments::Estimate(): histo == nullptr");
+  if(sideBandFraction < 0 || sideBandFraction >= 0.5) throw std::runtime_error("PeakMoments::Estimate(): sideBandFraction must be in [0, 0.5)");
+
+  std::vector<double> x;
+  std::vector<double> y;
+  for(int iBin = 1, nBins = histo->GetNbinsX(); iBin <= nBins; iBin++) {
+    const double binCenter = histo->GetBinCenter(iBin);
+    if(binCenter < xMin || binCenter > xMax) continue;
+    x.push_back(binCenter);
+    y.push_back(histo->GetBinContent(iBin));
+  }
+  const int nPoints = x.size();
+
+  PeakMoments result;
+  constexpr int minNPoints{5};
+  if(nPoints < minNPoints) return result;
+
+  // linear background through the mean points of the left and right outer bins
+  int iLo{0};
+  int iHi{nPoints};
+  if(sideBandFraction > 0) {
+    const int nSideBand = std::max(1, static_cast<int>(sideBandFraction * nPoints));
+    double xL{0.}, yL{0.}, xR{0.}, yR{0.};
+    for(int i = 0; i < nSideBand; i++) {
+      xL += x.at(i);
+      yL += y.at(i);
+      xR += x.at(nPoints - 1 - i);
+      yR += y.at(nPoints - 1 - i);
+    }
+    xL /= nSideBand; yL /= nSideBand; xR /= nSideBand; yR /= nSideBand;
+    for(int i = 0; i < nPoints; i++) {
+      y.at(i) -= yL + (yR - yL) * (x.at(i) - xL) / (xR - xL);
+    }
+    iLo = nSideBand;
+    iHi = nPoints - nSideBand;
+  }
+  if(iHi - iLo < 3) return result;
+
+  const int iMax = std::max_element(y.begin() + iLo, y.begin() + iHi) - y.begin();
+  result.height_ = y.at(iMax);
+  if(result.height_ <= 0) return result;
+
+  // FWHM with the linear interpolation between the bins crossing the half maximum
+  auto halfMaxCrossing = [&](int step) {
+    int i = iMax;
+    while(i + step >= iLo && i + step < iHi && y.at(i + step) > result.height_ / 2) i += step;
+    if(i + step < iLo || i + step >= iHi) return x.at(i);
+    const double y1 = y.at(i);
+    const double y2 = y.at(i + step);
+    return x.at(i) + (x.at(i + step) - x.at(i)) * (y1 - result.height_ / 2) / (y1 - y2);
+  };
+  const double binWidth = (x.back() - x.front()) / (nPoints - 1);
+  result.sigma_ = std::max((halfMaxCrossing(1) - halfMaxCrossing(-1)) / (2 * std::sqrt(2 * std::log(2.))), binWidth / 2);
+
+  result.mean_ = x.at(iMax);
+  for(int iIter = 0; iIter < 2; iIter++) {
+    double sumW{0.}, sumWX{0.}, sumWX2{0.};
+    for(int i = iLo; i < iHi; i++) {
+      if(std::abs(x.at(i) - result.mean_) > 3 * result.sigma_ || y.at(i) <= 0) continue;
+      sumW += y.at(i);
+      sumWX += y.at(i) * x.at(i);
+      sumWX2 += y.at(i) * x.at(i) * x.at(i);
+    }
+    if(sumW <= 0) return result;
+    result.mean_ = sumWX / sumW;
+    result.rms_ = std::sqrt(std::max(sumWX2 / sumW - result.mean_ * result.mean_, 0.));
+  }
+
+  double sumPositive{0.}, sumLeft{0.}, sumRight{0.};
+  for(int i = iLo; i < iHi; i++) {
+    const double u = (x.at(i) - result.mean_) / result.sigma_;
+    if(std::abs(u) > 5) continue;
+    result.integral_ += y.at(i);
+    if(y.at(i) <= 0) continue;
+    sumPositive += y.at(i);
+    if(u < -2) sumLeft += y.at(i);
+    if(u > 2) sumRight += y.at(i);
+  }
+  if(sumPositive <= 0 || result.integral_ <= 0) return result;
+  result.left_tail_ = sumLeft / sumPositive;
+  result.right_tail_ = sumRight / sumPositive;
+  result.is_valid_ = true;
+
+  return result;
+}
+
+double PeakMoments::TailFractionToAlpha(double tailFraction) {
+  constexpr double alphaMin{0.5};
+  constexpr double alphaMax{5.};
+  if(tailFraction <= 0) return alphaMax;
+  return std::clamp(TMath::NormQuantile(1. - std::min(tailFraction, 0.5)), alphaMin, alphaMax);
+}
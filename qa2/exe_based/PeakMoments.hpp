@@ -0,0 +1,29 @@
+#ifndef QA2_PEAKMOMENTS_HPP
+#define QA2_PEAKMOMENTS_HPP
+
+#include <TH1.h>
+
+/// Fast estimate of a peak's parameters from the bin moments of a histogram, to be used as the starting point of fits.
+/// A linear background is estimated from the outer bins of the range (sideBandFraction of them on each side) and subtracted.
+/// The core width is taken from the FWHM, which is insensitive to the tails, the mean and rms are the moments
+/// of the (positive part of the) subtracted content in a window of +-3 core widths around the maximum, refined twice.
+/// The tail fractions are the parts of the subtracted content beyond 2 core widths on each side.
+struct PeakMoments {
+  double mean_{0.};
+  double sigma_{0.};      // FWHM / 2.355
+  double rms_{0.};
+  double height_{0.};     // maximal background-subtracted bin content
+  double integral_{0.};   // sum of the background-subtracted bin contents within +-5 sigma_
+  double left_tail_{0.};  // fraction of the integral below mean_ - 2 sigma_ (0.023 for a Gaussian)
+  double right_tail_{0.}; // fraction of the integral above mean_ + 2 sigma_
+  bool is_valid_{false};
+
+  /// sideBandFraction = 0 disables the background subtraction (e.g. MC signal or an already subtracted histogram)
+  static PeakMoments Estimate(const TH1* histo, double xMin, double xMax, double sideBandFraction=0.2);
+
+  /// Rough crystal ball alpha (in sigmas) from a tail fraction: the distance from the mean at which a Gaussian
+  /// would have this tail fraction, so that heavier-than-Gaussian tails start earlier; limited to [0.5, 5]
+  static double TailFractionToAlpha(double tailFraction);
+};
+
+#endif //QA2_PEAKMOMENTS_HPP
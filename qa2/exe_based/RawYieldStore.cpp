@@ -0,0 +1,154 @@
+#include "RawYieldStore.hpp"
+
+#include <TChain.h>
+#include <TDirectory.h>
+#include <TH1D.h>
+
+#include <set>
+#include <stdexcept>
+
+namespace {
+const char* const kTreeName = "RawYieldStore";
+}
+
+RawYieldStoreWriter::RawYieldStoreWriter(const std::string& fileName, int trial) : trial_(trial) {
+  TDirectory::TContext context; // restores gDirectory
+  file_ = std::make_unique<TFile>(fileName.c_str(), "recreate");
+  if(file_->IsZombie()) throw std::runtime_error("RawYieldStoreWriter::RawYieldStoreWriter(): cannot create file " + fileName);
+  tree_ = new TTree(kTreeName, "mass-fit results: (trial, run, quantity) -> values in slices");
+  tree_->Branch("trial", &trial_);
+  tree_->Branch("run", &run_);
+  tree_->Branch("quantity", &quantity_);
+  tree_->Branch("title", &title_);
+  tree_->Branch("edges", &edges_);
+  tree_->Branch("values", &values_);
+  tree_->Branch("errors", &errors_);
+}
+
+RawYieldStoreWriter::~RawYieldStoreWriter() {
+  Close();
+}
+
+void RawYieldStoreWriter::Add(const std::string& run, const TH1* histo) {
+  if(histo == nullptr) throw std::runtime_error("RawYieldStoreWriter::Add(): histo == nullptr for run " + run);
+  if(file_ == nullptr) throw std::runtime_error("RawYieldStoreWriter::Add(): the store is closed");
+
+  run_ = run;
+  quantity_ = histo->GetName();
+  title_ = std::string(histo->GetTitle()) + ";" + histo->GetXaxis()->GetTitle() + ";" + histo->GetYaxis()->GetTitle();
+  const int nSlices = histo->GetNbinsX();
+  edges_.resize(nSlices + 1);
+  values_.resize(nSlices);
+  errors_.resize(nSlices);
+  for(int iSlice=0; iSlice<nSlices; ++iSlice) {
+    edges_.at(iSlice) = histo->GetXaxis()->GetBinLowEdge(iSlice + 1);
+    values_.at(iSlice) = histo->GetBinContent(iSlice + 1);
+    errors_.at(iSlice) = histo->GetBinError(iSlice + 1);
+  }
+  edges_.at(nSlices) = histo->GetXaxis()->GetBinUpEdge(nSlices);
+  tree_->Fill();
+}
+
+void RawYieldStoreWriter::Close() {
+  if(file_ == nullptr) return;
+
+  TDirectory::TContext context; // restores gDirectory
+  file_->cd();
+  tree_->Write();
+  file_->Close();
+  file_.reset();
+  tree_ = nullptr;
+}
+
+RawYieldStore::RawYieldStore(const std::string& fileNames) {
+  TChain chain(kTreeName);
+  if(chain.Add(fileNames.c_str()) == 0) throw std::runtime_error("RawYieldStore::RawYieldStore(): no files match " + fileNames);
+
+  int trial{0};
+  std::string* run{nullptr};
+  std::string* quantity{nullptr};
+  std::string* title{nullptr};
+  std::vector<double>* edges{nullptr};
+  std::vector<double>* values{nullptr};
+  std::vector<double>* errors{nullptr};
+  chain.SetBranchAddress("trial", &trial);
+  chain.SetBranchAddress("run", &run);
+  chain.SetBranchAddress("quantity", &quantity);
+  chain.SetBranchAddress("title", &title);
+  chain.SetBranchAddress("edges", &edges);
+  chain.SetBranchAddress("values", &values);
+  chain.SetBranchAddress("errors", &errors);
+
+  std::map<Key, std::string> recordFiles; // the file each record comes from
+  std::string error;
+  for(Long64_t iEntry=0, nEntries=chain.GetEntries(); iEntry<nEntries; ++iEntry) {
+    chain.GetEntry(iEntry);
+    const Key key{trial, *run, *quantity};
+    const std::string fileName = chain.GetFile()->GetName();
+    // a later record of the same key in the same file (e.g. a re-fitted run) overrides the earlier one,
+    // while the same key in another file means that the stores of different trials were not numbered apart
+    auto [itFile, isNew] = recordFiles.emplace(key, fileName);
+    if(!isNew && itFile->second != fileName) {
+      error = "record " + *quantity + " of run " + *run + " in trial " + std::to_string(trial) + " is both in " + itFile->second + " and in " + fileName;
+      break;
+    }
+    records_[key] = {*title, *edges, *values, *errors};
+  }
+  chain.ResetBranchAddresses();
+  delete run;
+  delete quantity;
+  delete title;
+  delete edges;
+  delete values;
+  delete errors;
+  if(!error.empty()) throw std::runtime_error("RawYieldStore::RawYieldStore(): " + error);
+}
+
+bool RawYieldStore::Has(const std::string& run, const std::string& quantity, int trial) const {
+  return records_.find({trial, run, quantity}) != records_.end();
+}
+
+std::pair<double, double> RawYieldStore::Get(const std::string& run, const std::string& quantity, int iSlice, int trial) const {
+  const Record& record = Find(run, quantity, trial);
+  if(iSlice < 0 || iSlice >= static_cast<int>(record.values_.size())) {
+    throw std::runtime_error("RawYieldStore::Get(): slice " + std::to_string(iSlice) + " is out of range for " + run + " " + quantity);
+  }
+  return {record.values_.at(iSlice), record.errors_.at(iSlice)};
+}
+
+const std::vector<double>& RawYieldStore::GetSliceEdges(const std::string& run, const std::string& quantity, int trial) const {
+  return Find(run, quantity, trial).edges_;
+}
+
+TH1* RawYieldStore::GetHisto(const std::string& run, const std::string& quantity, int trial) {
+  const Key key{trial, run, quantity};
+  auto& histo = histos_[key];
+  if(histo != nullptr) return histo.get();
+
+  const Record& record = Find(run, quantity, trial);
+  const int nSlices = static_cast<int>(record.values_.size());
+  TDirectory::TContext context(nullptr); // the histograms of different runs share the name, they are not attached to any directory
+  histo = std::make_unique<TH1D>(quantity.c_str(), record.title_.c_str(), nSlices, record.edges_.data());
+  for(int iSlice=0; iSlice<nSlices; ++iSlice) {
+    histo->SetBinContent(iSlice + 1, record.values_.at(iSlice));
+    histo->SetBinError(iSlice + 1, record.errors_.at(iSlice));
+  }
+
+  return histo.get();
+}
+
+std::vector<int> RawYieldStore::GetTrials() const {
+  std::set<int> trials;
+  for(const auto& [key, record] : records_) {
+    trials.insert(std::get<0>(key));
+  }
+  return {trials.begin(), trials.end()};
+}
+
+const RawYieldStore::Record& RawYieldStore::Find(const std::string& run, const std::string& quantity, int trial) const {
+  auto it = records_.find({trial, run, quantity});
+  if(it == records_.end()) {
+    throw std::runtime_error("RawYieldStore::Find(): no record " + quantity + " of run " + run + " in trial " + std::to_string(trial));
+  }
+  return it->second;
+}
@@ -0,0 +1,85 @@
+#ifndef QA2_RAWYIELDSTORE_HPP
+#define QA2_RAWYIELDSTORE_HPP
+
+#include <TFile.h>
+#include <TH1.h>
+#include <TTree.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/// Single indexed store of the mass-fit results, replacing one RawYields_*.root file per run (BDT score threshold)
+/// and per trial. A record is one result histogram of one run: (trial, run, quantity) -> the slice edges,
+/// the values and the errors in each slice, and the histogram title. The run is named as the per-run output file
+/// without the ".root" extension, e.g. "RawYields_Lc.NPgt0.25", the quantity as the histogram, e.g. "hRawYieldsSignal".
+/// The records are the entries of the TTree "RawYieldStore", so that the stores of several trials can be either
+/// merged with hadd, or read together with a wildcard.
+class RawYieldStoreWriter {
+ public:
+  RawYieldStoreWriter() = delete;
+  explicit RawYieldStoreWriter(const std::string& fileName, int trial=0);
+  RawYieldStoreWriter(const RawYieldStoreWriter&) = delete;
+  RawYieldStoreWriter& operator=(const RawYieldStoreWriter&) = delete;
+  virtual ~RawYieldStoreWriter();
+
+  /// Adds the histogram's bins as the record (trial, run, histo->GetName())
+  void Add(const std::string& run, const TH1* histo);
+
+  void Close();
+
+ private:
+  std::unique_ptr<TFile> file_{nullptr};
+  TTree* tree_{nullptr}; // owned by file_
+  int trial_{0};
+  std::string run_{};
+  std::string quantity_{};
+  std::string title_{};
+  std::vector<double> edges_{};
+  std::vector<double> values_{};
+  std::vector<double> errors_{};
+};
+
+/// Reader of the RawYieldStoreWriter output: all the records are loaded into memory at construction
+/// and are then randomly accessed by (run, quantity, trial)
+class RawYieldStore {
+ public:
+  RawYieldStore() = delete;
+  /// fileNames - a file name or a wildcard accepted by TChain::Add(), e.g. "trials/*/RawYields_Lc.NP.store.root".
+  /// Throws if the same (trial, run, quantity) is found in two files, e.g. the stores of trials which were all written as trial 0
+  explicit RawYieldStore(const std::string& fileNames);
+  virtual ~RawYieldStore() = default;
+
+  bool Has(const std::string& run, const std::string& quantity, int trial=0) const;
+
+  /// Value and error of the quantity in the slice (0-based, i.e. the histogram bin iSlice+1)
+  std::pair<double, double> Get(const std::string& run, const std::string& quantity, int iSlice, int trial=0) const;
+
+  const std::vector<double>& GetSliceEdges(const std::string& run, const std::string& quantity, int trial=0) const;
+
+  /// The record as a histogram, a drop-in replacement of the one read from the per-run file.
+  /// The histogram is created at the first call and is owned by the store
+  TH1* GetHisto(const std::string& run, const std::string& quantity, int trial=0);
+
+  /// Sorted numbers of the trials present in the store
+  std::vector<int> GetTrials() const;
+
+ private:
+  struct Record {
+    std::string title_;
+    std::vector<double> edges_;
+    std::vector<double> values_;
+    std::vector<double> errors_;
+  };
+  using Key = std::tuple<int, std::string, std::string>; // trial, run, quantity
+
+  const Record& Find(const std::string& run, const std::string& quantity, int trial) const;
+
+  std::map<Key, Record> records_{};
+  std::map<Key, std::unique_ptr<TH1>> histos_{};
+};
+
+#endif //QA2_RAWYIELDSTORE_HPP
@@ -4,10 +4,92 @@
 
 #include "ShapeFitter.hpp"
 
+#include "FitResultCache.hpp"
+#include "PeakMoments.hpp"
 #include "Shapes.hpp"
 
+#include <Fit/BinData.h>
+#include <Fit/Fitter.h>
+#include <HFitInterface.h>
+#include <Math/IParamFunction.h>
+#include <TMatrixDSym.h>
+#include <TVectorD.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 using namespace HelperGeneral;
 
+namespace {
+/// TF1 together with the analytic gradient over its parameters, as a model function of ROOT::Fit::Fitter
+class TF1WithGradient : public ROOT::Math::IParamMultiGradFunction {
+ public:
+  TF1WithGradient(TF1* func, ShapeFitter::Gradient gradient) : func_(func),
+                                                               gradient_(gradient),
+                                                               params_(func->GetParameters(), func->GetParameters() + func->GetNpar()) {}
+
+  ROOT::Math::IMultiGenFunction* Clone() const override { return new TF1WithGradient(*this); }
+  unsigned int NDim() const override { return 1; }
+  unsigned int NPar() const override { return params_.size(); }
+  const double* Parameters() const override { return params_.data(); }
+  void SetParameters(const double* p) override { std::copy(p, p + params_.size(), params_.begin()); }
+  void ParameterGradient(const double* x, const double* p, double* grad) const override { gradient_(x, p, grad); }
+
+ private:
+  double DoEvalPar(const double* x, const double* p) const override { return func_->EvalPar(x, p); }
+  double DoParameterDerivative(const double* x, const double* p, unsigned int iPar) const override {
+    std::vector<double> grad(params_.size());
+    gradient_(x, p, grad.data());
+    return grad.at(iPar);
+  }
+
+  TF1* func_;
+  ShapeFitter::Gradient gradient_;
+  std::vector<double> params_;
+};
+
+/// Sum of the PolN background and the peak shape, the peak parameters follow the background ones.
+/// The peak shape is a template parameter, so it is selected once when the TF1 is defined, not on each evaluation
+template<double (*PeakShape)(const double*, const double*)>
+double AllShape(const double* x, const double* par) {
+  return PolN::Shape(x, par) + PeakShape(x, &par[PolN::nPars]);
+}
+
+template<void (*PeakGradient)(const double*, const double*, double*)>
+void AllGradient(const double* x, const double* par, double* grad) {
+  PolN::Gradient(x, par, grad);
+  PeakGradient(x, &par[PolN::nPars], &grad[PolN::nPars]);
+}
+
+/// TFitResult of a fit solved without a minimiser: the parameters, their covariance (over all the parameters,
+/// zero for the fixed ones) and the chi2 are provided by the caller
+class SolvedFitResult : public TFitResult {
+ public:
+  SolvedFitResult(const ROOT::Fit::FitConfig& config, const std::vector<double>& params, const TMatrixDSym& cov, double chi2, unsigned int nPoints) :
+    TFitResult(ROOT::Fit::FitResult(config)) {
+    const unsigned int nPars = params.size();
+    fParams = params;
+    for(unsigned int iPar = 0; iPar < nPars; iPar++) {
+      fErrors.at(iPar) = std::sqrt(cov(iPar, iPar));
+    }
+    fCovMatrix.clear();
+    for(unsigned int iPar = 0; iPar < nPars; iPar++) {
+      for(unsigned int jPar = 0; jPar <= iPar; jPar++) {
+        fCovMatrix.push_back(cov(iPar, jPar));
+      }
+    }
+    fVal = chi2;
+    fChi2 = chi2;
+    fEdm = 0.;
+    fNdf = nPoints > fNFree ? nPoints - fNFree : 0;
+    fValid = true;
+    fStatus = 0;
+    fCovStatus = 3;
+  }
+};
+}
+
 void ShapeFitter::SetSideBands(double le, double li, double ri, double re) {
   left_sideband_external_ = le;
   left_sideband_internal_ = li;
@@ -26,7 +108,7 @@ void ShapeFitter::SetSideBandsViaSigma(double le, double li, double ri, double r
 }
 
 void ShapeFitter::Fit() {
-  PrepareHistoSidebands();
+  if(!use_linear_sideband_fit_) PrepareHistoSidebands();
   FitSideBands();
   PrepareHistoPeak();
   FitPeak();
@@ -36,20 +118,208 @@ void ShapeFitter::Fit() {
   EvaluateSigBgIntegrals();
 }
 
+void ShapeFitter::FitSimultaneous(const std::vector<ShapeFitter*>& fitters) {
+  if(fitters.empty()) throw std::runtime_error("ShapeFitter::FitSimultaneous(): fitters must not be empty");
+
+  SimultaneousBinnedFitter simultaneousFitter(BinnedFitter::Statistic::kChi2);
+  for(auto* fitter : fitters) {
+    if(fitter->peak_shape_ != fitters.front()->peak_shape_ || fitter->expected_mu_ != fitters.front()->expected_mu_) {
+      throw std::runtime_error("ShapeFitter::FitSimultaneous(): all the fitters must have the same peak shape and expected mu");
+    }
+    if(!fitter->use_linear_sideband_fit_) fitter->PrepareHistoSidebands();
+    fitter->FitSideBands();
+    fitter->PrepareHistoPeak();
+    fitter->FitPeak();
+    fitter->FitAll();
+    const BinnedFitter::Model model = fitter->GetAllModel();
+    simultaneousFitter.AddSpectrum(fitter->histo_in_, fitter->all_refit_, fitter->use_analytic_gradient_ ? model : BinnedFitter::Model{model.shape_, nullptr},
+                                   fitter->GetSharedPeakParameters());
+  }
+
+  const TFitResultPtr result = simultaneousFitter.Fit();
+  const TMatrixDSym covariance = result->GetCovarianceMatrix();
+  for(size_t iFitter = 0; iFitter < fitters.size(); iFitter++) {
+    auto* fitter = fitters.at(iFitter);
+    TF1* func = fitter->all_refit_;
+    const std::vector<int>& parIndices = simultaneousFitter.GetParIndices(iFitter);
+    const int nPars = func->GetNpar();
+    TMatrixDSym cov(nPars);
+    for(int iPar = 0; iPar < nPars; iPar++) {
+      for(int jPar = 0; jPar < nPars; jPar++) {
+        cov(iPar, jPar) = covariance(parIndices.at(iPar), parIndices.at(jPar));
+      }
+    }
+    ROOT::Fit::FitConfig config(nPars);
+    BinnedFitter::SetParameterSettings(config, func);
+    const SolvedFitResult spectrumResult(config, std::vector<double>(func->GetParameters(), func->GetParameters() + nPars), cov, func->GetChisquare(), func->GetNumberFitPoints());
+    fitter->all_refit_result_ptr_ = TFitResultPtr(new TFitResult(spectrumResult));
+    fitter->is_simultaneous_ = true;
+    fitter->RedefinePeakAndSideBand(fitter->left_sideband_external_, fitter->right_sideband_external_);
+    fitter->EvaluatePeakSigma();
+    fitter->EvaluateSigBgIntegrals();
+  }
+}
+
+std::vector<int> ShapeFitter::GetSharedPeakParameters() const {
+  std::vector<int> result;
+  if(peak_shape_ == "Gaus") result = {Gaus::kMu, Gaus::kSigma};
+  else if(peak_shape_ == "DoubleGaus") result = {DoubleGaus::kMu, DoubleGaus::kSigma1, DoubleGaus::kSigma2};
+  else if(peak_shape_ == "DSCB") result = {DoubleSidedCrystalBall::kMu, DoubleSidedCrystalBall::kSigma, DoubleSidedCrystalBall::kA1,
+                                           DoubleSidedCrystalBall::kN1, DoubleSidedCrystalBall::kA2, DoubleSidedCrystalBall::kN2};
+  else throw std::runtime_error("ShapeFitter::GetSharedPeakParameters() - peak_shape_ must be one of the available");
+  for(auto& iPar : result) iPar += PolN::nPars; // indices in the total model
+  return result;
+}
+
 void ShapeFitter::FitPeak() {
   DefinePeak(histo_peak_, left_sideband_external_, right_sideband_external_);
+  if(use_moment_estimate_) SeedPeakFromMoments(histo_peak_, left_sideband_external_, right_sideband_external_);
   peak_fit_->SetNpx(1000);
-  peak_fit_result_ptr_ = histo_peak_->Fit(peak_fit_, "RS0");
+  peak_fit_result_ptr_ = FitFunction(histo_peak_, peak_fit_, GetPeakModel());
 }
 
 void ShapeFitter::FitAll() {
   DefineAll(left_sideband_external_, right_sideband_external_);
-  all_refit_result_ptr_ = histo_in_->Fit(all_refit_, "RS0");
+  all_refit_result_ptr_ = FitFunction(histo_in_, all_refit_, GetAllModel());
 }
 
 void ShapeFitter::FitSideBands() {
   DefineSideBand(left_sideband_external_, right_sideband_external_);
-  sidebands_fit_result_ptr_ = histo_sidebands_->Fit(sidebands_fit_, "RS0");
+  sidebands_fit_result_ptr_ = use_linear_sideband_fit_ ? FitSideBandsLinear()
+                                                      : FitFunction(histo_sidebands_, sidebands_fit_, {EvaluateShapeBatch<PolN::Shape>, PolN::Gradient});
+}
+
+// The PolN with the fixed shift is linear in its free coefficients, so the chi2 minimum is the solution of the normal
+// equations A p = b, A = sum w phi phi^T, b = sum w y phi over the sideband bins with nonzero error (as in TH1::Fit()),
+// with phi_k = u^k, u = x - shift, w = 1 / error^2. The covariance of p is A^-1.
+// u is scaled by the half-width of the fit range for the conditioning of A, and the result is scaled back
+TFitResultPtr ShapeFitter::FitSideBandsLinear() {
+  const int nFree = bg_pol_n_ + 1;
+  const double shift = sidebands_fit_->GetParameter(PolN::kShift);
+  const double scale = std::max(std::abs(left_sideband_external_ - shift), std::abs(right_sideband_external_ - shift));
+
+  TMatrixDSym a(nFree);
+  TVectorD b(nFree);
+  std::vector<double> phi(nFree);
+  unsigned int nPoints{0};
+  const int nBins = histo_in_->GetNbinsX();
+  for(int iBin = 1; iBin <= nBins; iBin++) {
+    const double binCenter = histo_in_->GetBinCenter(iBin);
+    const double error = histo_in_->GetBinError(iBin);
+    if(!IsInSideBands(binCenter) || error <= 0) continue;
+    const double w = 1. / (error * error);
+    const double y = histo_in_->GetBinContent(iBin);
+    const double u = (binCenter - shift) / scale;
+    double uk = 1.;
+    for(int k = 0; k < nFree; k++) {
+      phi.at(k) = uk;
+      uk *= u;
+    }
+    for(int k = 0; k < nFree; k++) {
+      b(k) += w * y * phi.at(k);
+      for(int l = 0; l <= k; l++) {
+        a(k, l) += w * phi.at(k) * phi.at(l);
+      }
+    }
+    nPoints++;
+  }
+  for(int k = 0; k < nFree; k++) {
+    for(int l = 0; l < k; l++) {
+      a(l, k) = a(k, l);
+    }
+  }
+
+  double det{0.};
+  if(nFree > 0) a.Invert(&det);
+  if(nFree > 0 && (det == 0. || nPoints < static_cast<unsigned int>(nFree))) {
+    // degenerate sidebands (e.g. too few filled bins), left to the minimiser
+    return FitFunction(GetSideBandHisto(), sidebands_fit_, {EvaluateShapeBatch<PolN::Shape>, PolN::Gradient});
+  }
+  const TVectorD solution = a * b;
+
+  std::vector<double> params(PolN::nPars, 0.);
+  TMatrixDSym cov(PolN::nPars);
+  params.at(PolN::kShift) = shift;
+  for(int k = 0; k < nFree; k++) {
+    params.at(PolN::kConst + k) = solution(k) / std::pow(scale, k);
+    for(int l = 0; l < nFree; l++) {
+      cov(PolN::kConst + k, PolN::kConst + l) = a(k, l) / std::pow(scale, k + l);
+    }
+  }
+
+  double chi2{0.};
+  for(int iBin = 1; iBin <= nBins; iBin++) {
+    const double binCenter = histo_in_->GetBinCenter(iBin);
+    const double error = histo_in_->GetBinError(iBin);
+    if(!IsInSideBands(binCenter) || error <= 0) continue;
+    const double residual = histo_in_->GetBinContent(iBin) - PolN::Shape(&binCenter, params.data());
+    chi2 += residual * residual / (error * error);
+  }
+
+  sidebands_fit_->SetParameters(params.data());
+  ROOT::Fit::FitConfig config(PolN::nPars);
+  BinnedFitter::SetParameterSettings(config, sidebands_fit_);
+  const SolvedFitResult result(config, params, cov, chi2, nPoints);
+  sidebands_fit_->SetFitResult(result);
+  return TFitResultPtr(new TFitResult(result));
+}
+
+BinnedFitter::Model ShapeFitter::GetPeakModel() const {
+  if(peak_shape_ == "Gaus") return {EvaluateShapeBatch<Gaus::Shape>, Gaus::Gradient};
+  if(peak_shape_ == "DoubleGaus") return {EvaluateShapeBatch<DoubleGaus::Shape>, DoubleGaus::Gradient};
+  if(peak_shape_ == "DSCB") return {EvaluateShapeBatch<DoubleSidedCrystalBall::Shape>, DoubleSidedCrystalBall::Gradient};
+  throw std::runtime_error("ShapeFitter::GetPeakModel() - peak_shape_ must be one of the available");
+}
+
+BinnedFitter::Model ShapeFitter::GetAllModel() const {
+  if(peak_shape_ == "Gaus") return {EvaluateShapeBatch<AllShape<Gaus::Shape>>, AllGradient<Gaus::Gradient>};
+  if(peak_shape_ == "DoubleGaus") return {EvaluateShapeBatch<AllShape<DoubleGaus::Shape>>, AllGradient<DoubleGaus::Gradient>};
+  if(peak_shape_ == "DSCB") return {EvaluateShapeBatch<AllShape<DoubleSidedCrystalBall::Shape>>, AllGradient<DoubleSidedCrystalBall::Gradient>};
+  throw std::runtime_error("ShapeFitter::GetAllModel() - peak_shape_ must be one of the available");
+}
+
+// Equivalent of histo->Fit(func, "RS0"), optionally with the analytic gradient, the native fitter and the results' cache
+TFitResultPtr ShapeFitter::FitFunction(TH1* histo, TF1* func, const BinnedFitter::Model& model) const {
+  const FitResultCache cache(fit_cache_directory_);
+  std::string key;
+  if(cache.IsEnabled()) {
+    key = FitResultCache::MakeKey(histo, func->GetXmin(), func->GetXmax(), FitResultCache::DescribeFunction(func) + (use_analytic_gradient_ ? " gradient" : "") + (use_native_fitter_ ? " native" : ""));
+    if(TFitResult* cachedResult = cache.Get<TFitResult>(key)) {
+      func->SetFitResult(*cachedResult);
+      return TFitResultPtr(cachedResult);
+    }
+  }
+
+  TFitResultPtr result = Minimize(histo, func, model);
+  if(cache.IsEnabled() && result.Get() != nullptr) {
+    cache.Put(key, *result.Get());
+  }
+  return result;
+}
+
+TFitResultPtr ShapeFitter::Minimize(TH1* histo, TF1* func, const BinnedFitter::Model& model) const {
+  if(use_native_fitter_) {
+    const BinnedFitter fitter(histo, func->GetXmin(), func->GetXmax(), BinnedFitter::Statistic::kChi2);
+    return fitter.Fit(func, use_analytic_gradient_ ? model : BinnedFitter::Model{model.shape_, nullptr});
+  }
+  if(!use_analytic_gradient_) {
+    return histo->Fit(func, "RS0");
+  }
+
+  double xMin, xMax;
+  func->GetRange(xMin, xMax);
+  ROOT::Fit::DataOptions options;
+  ROOT::Fit::DataRange range(xMin, xMax);
+  ROOT::Fit::BinData data(options, range);
+  ROOT::Fit::FillData(data, histo, func);
+
+  ROOT::Fit::Fitter fitter;
+  fitter.SetFunction(TF1WithGradient(func, model.gradient_), true);
+  BinnedFitter::SetParameterSettings(fitter.Config(), func);
+  fitter.Fit(data);
+
+  func->SetFitResult(fitter.Result());
+  return TFitResultPtr(new TFitResult(fitter.Result()));
 }
 
 TPaveText* ShapeFitter::ConvertFitParametersToText(const std::string& funcType, std::array<float, 2> coordinatesLeftUpperCorner) const {
@@ -91,20 +361,29 @@ TPaveText* ShapeFitter::ConvertFitParametersToText(const std::string& funcType,
                   to_string_with_significant_figures(func->GetParameter(iPar), 3) + " #pm " +
                   to_string_with_significant_figures(func->GetParError(iPar), 3)).c_str());
   }
-  ptpar->AddText(("S = " + to_string_with_precision(GetSignalIntegral3Sigma(), 2) + " #pm " + to_string_with_precision(GetSignalErrIntegral3Sigma(), 2)).c_str());
+  ptpar->AddText(("S (" + GetYieldSource() + ") = " + to_string_with_precision(GetSignalIntegral3Sigma(), 2) + " #pm " + to_string_with_precision(GetSignalErrIntegral3Sigma(), 2)).c_str());
   ptpar->AddText(("S/B = " + to_string_with_precision(GetSignalIntegral3Sigma() / GetBgIntegral3Sigma(), 2)).c_str());
 
   return ptpar;
 }
 
+TH1* ShapeFitter::GetSideBandHisto() {
+  if(histo_sidebands_ == nullptr) PrepareHistoSidebands();
+  return histo_sidebands_;
+}
+
+bool ShapeFitter::IsInSideBands(double x) const {
+  return !(x < left_sideband_external_ ||
+           (x > left_sideband_internal_ && x < right_sideband_internal_) ||
+           x > right_sideband_external_);
+}
+
 void ShapeFitter::PrepareHistoSidebands() {
   histo_sidebands_ = dynamic_cast<TH1*>(histo_in_->Clone());
   const int nBins = histo_sidebands_->GetNbinsX();
   for(int iBin = 1; iBin <= nBins; iBin++) {
     const double binCenter = histo_sidebands_->GetBinCenter(iBin);
-    if(binCenter < left_sideband_external_ ||
-       (binCenter > left_sideband_internal_ && binCenter < right_sideband_internal_) ||
-       binCenter > right_sideband_external_) {
+    if(!IsInSideBands(binCenter)) {
       histo_sidebands_->SetBinContent(iBin, 0.);
       histo_sidebands_->SetBinError(iBin, 0.);
     }
@@ -127,22 +406,35 @@ void ShapeFitter::PrepareHistoPeak() {
 }
 
 void ShapeFitter::EvaluatePeakSigma() {
+  const TF1* peak = is_simultaneous_ ? peak_refit_ : peak_fit_;
   if(peak_shape_ == "Gaus") {
-    peak_sigma_ = peak_fit_->GetParameter(Gaus::kSigma);
+    peak_sigma_ = peak->GetParameter(Gaus::kSigma);
   } else if(peak_shape_ == "DoubleGaus") {
-    const double A1 = peak_fit_->GetParameter(DoubleGaus::kFactor1);
-    const double A2 = peak_fit_->GetParameter(DoubleGaus::kFactor2);
-    const double s1 = peak_fit_->GetParameter(DoubleGaus::kSigma1);
-    const double s2 = peak_fit_->GetParameter(DoubleGaus::kSigma2);
+    const double A1 = peak->GetParameter(DoubleGaus::kFactor1);
+    const double A2 = peak->GetParameter(DoubleGaus::kFactor2);
+    const double s1 = peak->GetParameter(DoubleGaus::kSigma1);
+    const double s2 = peak->GetParameter(DoubleGaus::kSigma2);
     peak_sigma_ = std::sqrt((A1*s1*s1 + A2*s2*s2) / (A1+A2));
   } else if(peak_shape_ == "DSCB") {
-    peak_sigma_ = peak_fit_->GetParameter(DoubleSidedCrystalBall::kSigma);
+    peak_sigma_ = peak->GetParameter(DoubleSidedCrystalBall::kSigma);
   } else {
     throw std::runtime_error("ShapeFitter::EvaluatePeakSigma() - peak_shape_ must be one of the available");
   }
 }
 
 void ShapeFitter::EvaluateSigBgIntegrals() {
+  if(is_simultaneous_) {
+    // the background and the peak are the blocks of the simultaneous total fit, their covariances are the blocks of its one
+    const TMatrixDSym covariance = all_refit_result_ptr_->GetCovarianceMatrix();
+    const int nPeakPars = peak_refit_->GetNpar();
+    const TMatrixDSym covarianceBg = covariance.GetSub(0, PolN::nPars - 1);
+    const TMatrixDSym covariancePeak = covariance.GetSub(PolN::nPars, PolN::nPars + nPeakPars - 1);
+    peak_integral_3s_ = peak_refit_->Integral(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_) / histo_in_->GetBinWidth(1);
+    bg_integral_3s_ = sidebands_refit_->Integral(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_) / histo_in_->GetBinWidth(1);
+    peak_errintegral_3s_ = peak_refit_->IntegralError(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_, peak_refit_->GetParameters(), covariancePeak.GetMatrixArray()) / histo_in_->GetBinWidth(1);
+    bg_errintegral_3s_ = sidebands_refit_->IntegralError(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_, sidebands_refit_->GetParameters(), covarianceBg.GetMatrixArray()) / histo_in_->GetBinWidth(1);
+    return;
+  }
   peak_integral_3s_ = peak_fit_->Integral(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_) / histo_in_->GetBinWidth(1);
   bg_integral_3s_ = sidebands_fit_->Integral(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_) / histo_in_->GetBinWidth(1);
   peak_errintegral_3s_ = peak_fit_->IntegralError(expected_mu_ - 3*peak_sigma_, expected_mu_ + 3*peak_sigma_, peak_fit_result_ptr_->GetParams(), peak_fit_result_ptr_->GetCovarianceMatrix().GetMatrixArray()) / histo_in_->GetBinWidth(1);
@@ -182,14 +474,13 @@ void ShapeFitter::DefineSideBand(double left, double right) {
 }
 
 void ShapeFitter::DefineAll(double left, double right) {
-  auto AllShape = [&] (const double* x, const double* par) {
-    if(peak_shape_ == "Gaus") return PolN::Shape(x, par) + Gaus::Shape(x, &par[PolN::nPars]);
-    if(peak_shape_ == "DoubleGaus") return PolN::Shape(x, par) + DoubleGaus::Shape(x, &par[PolN::nPars]);
-    if(peak_shape_ == "DSCB") return PolN::Shape(x, par) + DoubleSidedCrystalBall::Shape(x, &par[PolN::nPars]);
-    throw std::runtime_error("ShapeFitter::DefineAll() - peak_shape_ must be one of the availables");
-  };
-  all_fit_ = new TF1("all_fit", AllShape, left, right, peak_fit_->GetNpar() + PolN::nPars);
-  all_refit_ = new TF1("all_refit", AllShape, left, right, peak_fit_->GetNpar() + PolN::nPars);
+  double (*allShape)(const double*, const double*);
+  if     (peak_shape_ == "Gaus")       allShape = AllShape<Gaus::Shape>;
+  else if(peak_shape_ == "DoubleGaus") allShape = AllShape<DoubleGaus::Shape>;
+  else if(peak_shape_ == "DSCB")       allShape = AllShape<DoubleSidedCrystalBall::Shape>;
+  else                                 throw std::runtime_error("ShapeFitter::DefineAll() - peak_shape_ must be one of the availables");
+  all_fit_ = new TF1("all_fit", allShape, left, right, peak_fit_->GetNpar() + PolN::nPars);
+  all_refit_ = new TF1("all_refit", allShape, left, right, peak_fit_->GetNpar() + PolN::nPars);
   CopyPasteParametersToAll(sidebands_fit_, PolN::nPars, 0);
   CopyPasteParametersToAll(peak_fit_, peak_fit_->GetNpar(), PolN::nPars);
   all_fit_->SetNpx(1000);
@@ -221,6 +512,37 @@ void ShapeFitter::DefinePeak(TH1* histo, float left, float right) {
   else                                  throw std::runtime_error("ShapeFitter::DefinePeak(): peak_shape_ must be one of the available");
 }
 
+// The starting values are kept within the limits set by DefinePeak*(); the histogram is background-subtracted already
+void ShapeFitter::SeedPeakFromMoments(const TH1* histo, double left, double right) {
+  const PeakMoments moments = PeakMoments::Estimate(histo, left, right, 0.);
+  if(!moments.is_valid_) return;
+
+  auto setParameter = [&](int iPar, double value) {
+    double parMin, parMax;
+    peak_fit_->GetParLimits(iPar, parMin, parMax);
+    if(parMin < parMax) value = std::clamp(value, parMin, parMax);
+    peak_fit_->SetParameter(iPar, value);
+  };
+
+  if(peak_shape_ == "Gaus") {
+    setParameter(Gaus::kFactor, moments.height_);
+    setParameter(Gaus::kMu, moments.mean_ - expected_mu_);
+    setParameter(Gaus::kSigma, moments.sigma_);
+  } else if(peak_shape_ == "DoubleGaus") {
+    setParameter(DoubleGaus::kFactor1, moments.height_ / 2);
+    setParameter(DoubleGaus::kFactor2, moments.height_ / 2);
+    setParameter(DoubleGaus::kMu, moments.mean_ - expected_mu_);
+    setParameter(DoubleGaus::kSigma1, moments.sigma_);
+    setParameter(DoubleGaus::kSigma2, std::max(moments.rms_, 2 * moments.sigma_));
+  } else if(peak_shape_ == "DSCB") {
+    setParameter(DoubleSidedCrystalBall::kFactor, moments.height_);
+    setParameter(DoubleSidedCrystalBall::kMu, moments.mean_ - expected_mu_);
+    setParameter(DoubleSidedCrystalBall::kSigma, moments.sigma_);
+    setParameter(DoubleSidedCrystalBall::kA1, PeakMoments::TailFractionToAlpha(moments.left_tail_));
+    setParameter(DoubleSidedCrystalBall::kA2, PeakMoments::TailFractionToAlpha(moments.right_tail_));
+  }
+}
+
 void ShapeFitter::DefinePeakGaus(TH1* histo, double left, double right) {
   peak_fit_ = new TF1("peak_fit", Gaus::Shape, left, right, Gaus::nPars);
   peak_fit_->SetParameter(Gaus::kFactor, histo->Interpolate(expected_mu_));
@@ -5,6 +5,7 @@
 #ifndef QA2_SHAPEFITTER_HPP
 #define QA2_SHAPEFITTER_HPP
 
+#include "BinnedFitter.hpp"
 #include "HelperGeneral.hpp"
 
 #include <TF1.h>
@@ -12,8 +13,14 @@
 #include <TH1.h>
 #include <TPaveText.h>
 
+#include <string>
+#include <vector>
+
 class ShapeFitter {
  public:
+  /// Partial derivatives of a shape over its parameters, see Shapes.hpp
+  using Gradient = BinnedFitter::Gradient;
+
   explicit ShapeFitter(TH1* histo) { histo_in_ = histo; }
   virtual ~ShapeFitter() = default;
 
@@ -23,13 +30,15 @@ class ShapeFitter {
   int GetPeakNDF() const { return peak_fit_->GetNDF(); }
   double GetPeakChi2OverNDF() const { return GetPeakChi2() / GetPeakNDF(); }
   TH1* GetPeakHisto() const { return histo_peak_; }
+  TFitResultPtr GetPeakFitResult() const { return peak_fit_result_ptr_; }
 
   TF1* GetSideBandFunc() const { return sidebands_fit_; }
   TF1* GetSideBandReFunc() const { return sidebands_refit_; }
   double GetSideBandChi2() const { return sidebands_fit_->GetChisquare(); }
   int GetSideBandNDF() const { return sidebands_fit_->GetNDF(); }
   double GetSideBandChi2OverNDF() const { return GetSideBandChi2() / GetSideBandNDF(); }
-  TH1* GetSideBandHisto() const { return histo_sidebands_; }
+  /// The input histogram with the bins outside the sidebands zeroed; with the linear sideband fit it is built on request only
+  TH1* GetSideBandHisto();
 
   TF1* GetAllFunc() const { return all_fit_; }
   TF1* GetAllReFunc() const { return all_refit_; }
@@ -42,6 +51,10 @@ class ShapeFitter {
   TH1* GetAllHisto() const { return histo_in_; }
 
   double GetPeakSigma() const { return peak_sigma_; }
+  /// The signal and background integrals within 3 sigma come from the separate sideband and peak pre-fits after Fit(),
+  /// but from the simultaneous re-fit (with the peak shape shared between the spectra) after FitSimultaneous().
+  /// GetYieldSource() names the fit they come from, to label the output
+  std::string GetYieldSource() const { return is_simultaneous_ ? "simultaneous fit" : "pre-fit"; }
   double GetSignalIntegral3Sigma() const { return peak_integral_3s_; }
   double GetBgIntegral3Sigma() const { return bg_integral_3s_; }
   double GetSignalErrIntegral3Sigma() const { return peak_errintegral_3s_; }
@@ -53,28 +66,58 @@ class ShapeFitter {
   void SetSideBandsViaSigma(double le, double li, double ri, double re);
   void SetPeakShape(const std::string& shapeName) { peak_shape_ = shapeName; }
   void SetBgPolN(int polN) { bg_pol_n_ = polN; }
+  /// Fit with the analytic gradients of the shapes instead of the MINUIT's finite differences
+  void SetUseAnalyticGradient(bool value=true) { use_analytic_gradient_ = value; }
+  /// Fit with the BinnedFitter (chi2 over the bins evaluated in batch, Minuit2) instead of TH1::Fit()
+  void SetUseNativeFitter(bool value=true) { use_native_fitter_ = value; }
+  /// Solve the sideband PolN fit as the linear weighted least squares (normal equations on the sideband bins of the
+  /// input histogram) instead of the iterative one; the result and covariance are exact, the fit is deterministic
+  void SetUseLinearSideBandFit(bool value=true) { use_linear_sideband_fit_ = value; }
+  /// Seed the peak fit with the moments of the background-subtracted histogram (see PeakMoments) instead of
+  /// the expected mu and sigma; the parameters' limits are still defined by the expected values
+  void SetUseMomentEstimate(bool value=true) { use_moment_estimate_ = value; }
+  /// Directory of the on-disk cache of the fit results (see FitResultCache); the cache is disabled if empty
+  void SetFitCacheDirectory(const std::string& directory) { fit_cache_directory_ = directory; }
 
   void Fit();
 
+  /// Fits the input histograms of all the fitters together with the total (PolN + peak) model: the peak shape
+  /// (position, widths, tails) is shared, the heights and the backgrounds are per spectrum. Each fitter first runs
+  /// its own sideband, peak and total fits, which provide the starting values; the simultaneous result is stored
+  /// as the re-fit (GetAllReFunc() etc.), and the peak sigma and the integrals are evaluated from it.
+  /// All the fitters must have the same peak shape and expected mu; the native fitter is used regardless of
+  /// SetUseNativeFitter(), and the cache is not
+  static void FitSimultaneous(const std::vector<ShapeFitter*>& fitters);
+
   TPaveText* ConvertFitParametersToText(const std::string& funcType, std::array<float, 2> coordinatesLeftUpperCorner) const;
 
  private:
   void FitPeak();
   void FitSideBands();
+  TFitResultPtr FitSideBandsLinear();
   void FitAll();
 
   void DefinePeakGaus(TH1* h, double left, double right);
   void DefinePeakDoubleGaus(TH1* histo, double left, double right);
   void DefinePeakDSCB(TH1* histo, float left, float right);
+  void SeedPeakFromMoments(const TH1* histo, double left, double right);
+
+  std::vector<int> GetSharedPeakParameters() const;
 
   void CopyPasteParametersToAll(const TF1* funcFrom, int nParsFunc, int nParsShift);
 
+  BinnedFitter::Model GetPeakModel() const;
+  BinnedFitter::Model GetAllModel() const;
+  TFitResultPtr FitFunction(TH1* histo, TF1* func, const BinnedFitter::Model& model) const;
+  TFitResultPtr Minimize(TH1* histo, TF1* func, const BinnedFitter::Model& model) const;
+
   void DefinePeak(TH1* histo, float left, float right);
   void DefineSideBand(double left, double right);
   void DefineAll(double left, double right);
 
   void RedefinePeakAndSideBand(double left, double right);
 
+  bool IsInSideBands(double x) const;
   void PrepareHistoSidebands();
   void PrepareHistoPeak();
 
@@ -112,5 +155,11 @@ class ShapeFitter {
 
   std::string peak_shape_{"Gaus"};
   int bg_pol_n_{2};
+  bool use_analytic_gradient_{false};
+  bool use_native_fitter_{false};
+  bool use_linear_sideband_fit_{false};
+  bool use_moment_estimate_{false};
+  bool is_simultaneous_{false}; // the re-fit is the simultaneous one, see FitSimultaneous()
+  std::string fit_cache_directory_{};
 };
 #endif //QA2_SHAPEFITTER_HPP
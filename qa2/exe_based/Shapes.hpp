@@ -7,6 +7,8 @@
 
 #include <TMath.h>
 
+#include <cstddef>
+
 namespace PolN {
 enum Pars : int {
   kShift = 0,
@@ -28,6 +30,21 @@ inline double Shape(const double* x, const double* par) {
 
   return a0 + a1 * u + a2 * u*u + a3 * u*u*u;
 }
+
+/// Partial derivatives of Shape() over par, grad has nPars elements
+inline void Gradient(const double* x, const double* par, double* grad) {
+  double a1 = par[kSlope];
+  double a2 = par[kSecond];
+  double a3 = par[kThird];
+
+  double u = x[0] - par[kShift];
+
+  grad[kShift] = -(a1 + 2 * a2 * u + 3 * a3 * u*u);
+  grad[kConst] = 1.;
+  grad[kSlope] = u;
+  grad[kSecond] = u*u;
+  grad[kThird] = u*u*u;
+}
 }
 
 namespace Gaus {
@@ -49,6 +66,20 @@ inline double Shape(const double* x, const double* par) {
 
   return factor * TMath::Exp(-u * u / 2);
 }
+
+/// Partial derivatives of Shape() over par, grad has nPars elements
+inline void Gradient(const double* x, const double* par, double* grad) {
+  double factor = par[kFactor];
+  double sigma = par[kSigma];
+
+  double u = (x[0] - par[kShift] - par[kMu]) / sigma;
+  double e = TMath::Exp(-u * u / 2);
+
+  grad[kFactor] = e;
+  grad[kShift] = factor * e * u / sigma;
+  grad[kMu] = grad[kShift];
+  grad[kSigma] = factor * e * u * u / sigma;
+}
 }
 
 namespace DoubleGaus {
@@ -75,6 +106,26 @@ inline double Shape(const double* x, const double* par) {
 
   return factor1 * TMath::Exp(-u1 * u1 / 2) + factor2 * TMath::Exp(-u2 * u2 / 2);
 }
+
+/// Partial derivatives of Shape() over par, grad has nPars elements
+inline void Gradient(const double* x, const double* par, double* grad) {
+  double factor1 = par[kFactor1];
+  double factor2 = par[kFactor2];
+  double sigma1 = par[kSigma1];
+  double sigma2 = par[kSigma2];
+
+  double u1 = (x[0] - par[kShift] - par[kMu]) / sigma1;
+  double u2 = (x[0] - par[kShift] - par[kMu]) / sigma2;
+  double e1 = TMath::Exp(-u1 * u1 / 2);
+  double e2 = TMath::Exp(-u2 * u2 / 2);
+
+  grad[kFactor1] = e1;
+  grad[kFactor2] = e2;
+  grad[kShift] = factor1 * e1 * u1 / sigma1 + factor2 * e2 * u2 / sigma2;
+  grad[kMu] = grad[kShift];
+  grad[kSigma1] = factor1 * e1 * u1 * u1 / sigma1;
+  grad[kSigma2] = factor2 * e2 * u2 * u2 / sigma2;
+}
 }
 
 namespace DoubleSidedCrystalBall {
@@ -111,6 +162,56 @@ inline double Shape(const double* x, const double* par) {
   else
     return -1.;
 }
+
+/// Partial derivatives of Shape() over par, grad has nPars elements.
+/// In each region the shape is factor * exp(g(u)), the derivatives are factor * exp(g) * dg/dpar
+inline void Gradient(const double* x, const double* par, double* grad) {
+  double factor = par[kFactor];
+  double sigma = par[kSigma];
+  double a1 = par[kA1];
+  double n1 = TMath::Power(10, par[kN1]);
+  double a2 = par[kA2];
+  double n2 = TMath::Power(10, par[kN2]);
+
+  double u = (x[0] - par[kShift] - par[kMu]) / sigma;
+
+  for (int iPar = 0; iPar < nPars; iPar++) {
+    grad[iPar] = 0.;
+  }
+  double shape; // exp(g)
+  double dgdu;
+  if (u < -a1) {
+    double b = 1 - a1 * (u + a1) / n1;
+    shape = TMath::Exp(-a1 * a1 / 2) * TMath::Power(b, -n1);
+    dgdu = a1 / b;
+    grad[kA1] = factor * shape * (-a1 + (u + 2 * a1) / b);
+    grad[kN1] = factor * shape * (-TMath::Log(b) - a1 * (u + a1) / (n1 * b)) * n1 * TMath::Ln10();
+  } else if (u >= -a1 && u < a2) {
+    shape = TMath::Exp(-u * u / 2);
+    dgdu = -u;
+  } else if (u >= a2) {
+    double c = 1 + a2 * (u - a2) / n2;
+    shape = TMath::Exp(-a2 * a2 / 2) * TMath::Power(c, -n2);
+    dgdu = -a2 / c;
+    grad[kA2] = factor * shape * (-a2 - (u - 2 * a2) / c);
+    grad[kN2] = factor * shape * (-TMath::Log(c) + a2 * (u - a2) / (n2 * c)) * n2 * TMath::Ln10();
+  } else {
+    return;
+  }
+  grad[kFactor] = shape;
+  grad[kShift] = -factor * shape * dgdu / sigma;
+  grad[kMu] = grad[kShift];
+  grad[kSigma] = -factor * shape * dgdu * u / sigma;
+}
+}
+
+/// Evaluates Shape at nX points, out[i] = Shape(&x[i], par). The shape is a template parameter, so that it is inlined
+/// into the loop over the points, which can then be vectorised
+template<double (*Shape)(const double*, const double*)>
+inline void EvaluateShapeBatch(const double* x, size_t nX, const double* par, double* out) {
+  for (size_t i = 0; i < nX; i++) {
+    out[i] = Shape(&x[i], par);
+  }
 }
 
 #endif //QA2_SHAPES_HPP
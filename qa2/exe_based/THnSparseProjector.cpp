@@ -0,0 +1,287 @@
+#include "THnSparseProjector.hpp"
+
+#include "HelperGeneral.hpp"
+
+#include <TAxis.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+THnSparseWeightedView::THnSparseWeightedView(const THnSparse* histo, int axis, const TH1* histoWeight) : histo_(histo), axis_(axis) {
+  if(histo == nullptr || histoWeight == nullptr) throw std::runtime_error("THnSparseWeightedView::THnSparseWeightedView(): histo == nullptr || histoWeight == nullptr");
+  if(axis < 0 || axis >= histo->GetNdimensions()) throw std::runtime_error("THnSparseWeightedView::THnSparseWeightedView(): axis is out of range");
+  weights_ = HelperGeneral::EvaluateWeightLookupTable(histo->GetAxis(axis), histoWeight);
+}
+
+THnSparseProjector::THnSparseProjector(const THnSparseWeightedView& histo, int projAxis) : histo_in_(histo.histo_), view_(histo), proj_axis_(projAxis) {
+  if(histo_in_ == nullptr) throw std::runtime_error("THnSparseProjector::THnSparseProjector(): histo == nullptr");
+  if(projAxis < 0 || projAxis >= histo_in_->GetNdimensions()) throw std::runtime_error("THnSparseProjector::THnSparseProjector(): projAxis is out of range");
+  proj_n_bins_ = histo_in_->GetAxis(projAxis)->GetNbins() + 2;
+}
+
+void THnSparseProjector::SetScanAxis(int axis) {
+  if(!slice_dims_.empty()) throw std::runtime_error("THnSparseProjector::SetScanAxis(): must be called before AddSliceDimension()");
+  if(axis < 0 || axis >= histo_in_->GetNdimensions() || axis == proj_axis_) throw std::runtime_error("THnSparseProjector::SetScanAxis(): axis is out of range or coincides with the projection one");
+  scan_axis_requested_ = axis;
+  ApplyScanAxis();
+}
+
+void THnSparseProjector::SetUseScanSuffixSums(bool value) {
+  if(!slice_dims_.empty()) throw std::runtime_error("THnSparseProjector::SetUseScanSuffixSums(): must be called before AddSliceDimension()");
+  is_use_scan_suffix_sums_ = value;
+  ApplyScanAxis();
+}
+
+void THnSparseProjector::ApplyScanAxis() {
+  scan_axis_ = is_use_scan_suffix_sums_ ? scan_axis_requested_ : -1;
+  scan_n_bins_ = scan_axis_ >= 0 ? histo_in_->GetAxis(scan_axis_)->GetNbins() + 2 : 1;
+}
+
+size_t THnSparseProjector::AddSliceDimension(const std::vector<Selection>& selections) {
+  if(is_run_) throw std::runtime_error("THnSparseProjector::AddSliceDimension(): slices cannot be added after Run()");
+  if(selections.empty()) throw std::runtime_error("THnSparseProjector::AddSliceDimension(): selections are empty");
+
+  auto IsSameCut = [](const AxisBinCut& a, const AxisBinCut& b) {
+    return a.axis_ == b.axis_ && a.bin_lo_ == b.bin_lo_ && a.bin_hi_ == b.bin_hi_;
+  };
+
+  SliceDimension dim;
+  for(const auto& selection : selections) {
+    std::vector<AxisBinCut> binCuts;
+    std::pair<int, int> scanRange{0, scan_n_bins_-1};
+    for(const auto& cut : selection) {
+      if(cut.axis_ < 0 || cut.axis_ >= histo_in_->GetNdimensions()) throw std::runtime_error("THnSparseProjector::AddSliceDimension(): cut axis is out of range");
+      const auto [binLo, binHi] = HelperGeneral::FindTAxisBinRange(histo_in_->GetAxis(cut.axis_), cut.lo_, cut.hi_);
+      if(cut.axis_ == scan_axis_) {
+        scanRange = {std::max(scanRange.first, binLo), std::min(scanRange.second, binHi)};
+        continue;
+      }
+      binCuts.push_back({cut.axis_, binLo, binHi});
+      if(std::find(dim.axes_.begin(), dim.axes_.end(), cut.axis_) == dim.axes_.end()) dim.axes_.emplace_back(cut.axis_);
+    }
+    std::sort(binCuts.begin(), binCuts.end(), [](const AxisBinCut& a, const AxisBinCut& b) { return a.axis_ < b.axis_; });
+    auto base = std::find_if(dim.bases_.begin(), dim.bases_.end(), [&](const std::vector<AxisBinCut>& b) {
+      return std::equal(b.begin(), b.end(), binCuts.begin(), binCuts.end(), IsSameCut);
+    });
+    if(base == dim.bases_.end()) base = dim.bases_.insert(dim.bases_.end(), binCuts);
+    dim.selection_base_.emplace_back(std::distance(dim.bases_.begin(), base));
+    dim.selection_scan_.emplace_back(scanRange);
+  }
+  BuildLookupTable(dim);
+  slice_dims_.emplace_back(std::move(dim));
+
+  return slice_dims_.size() - 1;
+}
+
+void THnSparseProjector::BuildLookupTable(SliceDimension& dim) const {
+  constexpr size_t maxLookupSize{10000000};
+
+  size_t nCells{1};
+  dim.axes_strides_.resize(dim.axes_.size());
+  for(int iAxis=dim.axes_.size()-1; iAxis>=0; --iAxis) {
+    dim.axes_strides_.at(iAxis) = nCells;
+    nCells *= histo_in_->GetAxis(dim.axes_.at(iAxis))->GetNbins() + 2;
+    if(nCells > maxLookupSize) throw std::runtime_error("THnSparseProjector::BuildLookupTable(): too many axes' bins combinations in a slice dimension");
+  }
+
+  std::vector<int> coords(histo_in_->GetNdimensions(), 0);
+  dim.lookup_offsets_.assign(1, 0);
+  dim.lookup_indices_.clear();
+  for(size_t iCell=0; iCell<nCells; ++iCell) {
+    for(size_t iAxis=0; iAxis<dim.axes_.size(); ++iAxis) {
+      const int nBins = histo_in_->GetAxis(dim.axes_.at(iAxis))->GetNbins() + 2;
+      coords.at(dim.axes_.at(iAxis)) = iCell / dim.axes_strides_.at(iAxis) % nBins;
+    }
+    for(size_t iBase=0; iBase<dim.bases_.size(); ++iBase) {
+      const auto& binCuts = dim.bases_.at(iBase);
+      const bool isAccepted = std::all_of(binCuts.begin(), binCuts.end(), [&](const AxisBinCut& bc) {
+        return coords.at(bc.axis_) >= bc.bin_lo_ && coords.at(bc.axis_) <= bc.bin_hi_;
+      });
+      if(isAccepted) dim.lookup_indices_.emplace_back(iBase);
+    }
+    dim.lookup_offsets_.emplace_back(dim.lookup_indices_.size());
+  }
+}
+
+size_t THnSparseProjector::GetLookupCell(const SliceDimension& dim, const int* coords) const {
+  size_t cell{0};
+  for(size_t iAxis=0; iAxis<dim.axes_.size(); ++iAxis) {
+    cell += coords[dim.axes_[iAxis]] * dim.axes_strides_[iAxis];
+  }
+  return cell;
+}
+
+void THnSparseProjector::SetNThreads(int nThreads) {
+  if(nThreads < 1) throw std::runtime_error("THnSparseProjector::SetNThreads(): nThreads < 1");
+  n_threads_ = nThreads;
+}
+
+void THnSparseProjector::Run() {
+  if(is_run_) throw std::runtime_error("THnSparseProjector::Run(): is called twice");
+
+  // filled bins are decoded serially in blocks (THnSparse bin accessors share an internal coordinate buffer
+  // and thus are not thread-safe), and each block is accumulated in parallel into per-thread buffers
+  constexpr Long64_t blockSize{1<<18};
+
+  size_t nTargets{1};
+  for(const auto& dim : slice_dims_) {
+    nTargets *= dim.bases_.size();
+  }
+  const size_t accSize = nTargets * scan_n_bins_ * proj_n_bins_;
+  const int nThreads = n_threads_;
+  std::vector<std::vector<double>> sumws(nThreads, std::vector<double>(accSize, 0.));
+  std::vector<std::vector<double>> sumw2s(nThreads, std::vector<double>(accSize, 0.));
+
+  const bool hasErrors = histo_in_->GetCalculateErrors();
+  const bool isWeighted = view_.IsWeighted();
+  const int nAxes = histo_in_->GetNdimensions();
+  std::vector<int> coords(blockSize * nAxes);
+  std::vector<double> contents(blockSize), err2s(blockSize);
+
+  const Long64_t nFilledBins = histo_in_->GetNbins();
+  for(Long64_t iBlockStart=0; iBlockStart<nFilledBins; iBlockStart+=blockSize) {
+    size_t nBlockBins{0};
+    for(Long64_t iBin=iBlockStart, iBlockEnd=std::min(iBlockStart+blockSize, nFilledBins); iBin<iBlockEnd; ++iBin) {
+      int* binCoords = &coords[nBlockBins*nAxes];
+      double content = histo_in_->GetBinContent(iBin, binCoords);
+      double err2 = hasErrors ? histo_in_->GetBinError2(iBin) : content;
+      if(content == 0. && err2 == 0.) continue;
+      if(isWeighted) {
+        const double weight = view_.GetWeight(binCoords);
+        content *= weight;
+        err2 *= weight * weight;
+      }
+      contents[nBlockBins] = content;
+      err2s[nBlockBins] = err2;
+      ++nBlockBins;
+    }
+
+    if(nThreads == 1 || nBlockBins < static_cast<size_t>(nThreads)) {
+      AccumulateBins(coords.data(), contents.data(), err2s.data(), nBlockBins, sumws.at(0).data(), sumw2s.at(0).data());
+      continue;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads);
+    for(int iThread=0; iThread<nThreads; ++iThread) {
+      const size_t from = nBlockBins * iThread / nThreads;
+      const size_t to = nBlockBins * (iThread + 1) / nThreads;
+      threads.emplace_back(&THnSparseProjector::AccumulateBins, this, &coords[from*nAxes], &contents[from], &err2s[from], to - from,
+                           sumws.at(iThread).data(), sumw2s.at(iThread).data());
+    }
+    for(auto& thread : threads) {
+      thread.join();
+    }
+  } // nFilledBins
+
+  // reduce in the fixed thread order, so that the result does not depend on the scheduling
+  sumw_ = std::move(sumws.at(0));
+  sumw2_ = std::move(sumw2s.at(0));
+  for(int iThread=1; iThread<nThreads; ++iThread) {
+    for(size_t i=0; i<accSize; ++i) {
+      sumw_[i] += sumws.at(iThread)[i];
+      sumw2_[i] += sumw2s.at(iThread)[i];
+    }
+  }
+
+  ConvertToSuffixSums();
+  is_run_ = true;
+}
+
+void THnSparseProjector::AccumulateBins(const int* coords, const double* contents, const double* err2s, size_t nBins, double* sumw, double* sumw2) const {
+  const size_t nDims = slice_dims_.size();
+  const int nAxes = histo_in_->GetNdimensions();
+  std::vector<size_t> from(nDims), to(nDims), current(nDims);
+
+  for(size_t iBin=0; iBin<nBins; ++iBin) {
+    const int* binCoords = &coords[iBin*nAxes];
+    bool isAccepted{true};
+    for(size_t iDim=0; iDim<nDims && isAccepted; ++iDim) {
+      const auto& dim = slice_dims_[iDim];
+      const size_t cell = GetLookupCell(dim, binCoords);
+      from[iDim] = dim.lookup_offsets_[cell];
+      to[iDim] = dim.lookup_offsets_[cell+1];
+      isAccepted = from[iDim] != to[iDim];
+    }
+    if(!isAccepted) continue;
+
+    // iterate over all combinations of the accepting bases
+    std::copy(from.begin(), from.end(), current.begin());
+    const size_t scanProjBin = (scan_axis_ >= 0 ? binCoords[scan_axis_] : 0) * proj_n_bins_ + binCoords[proj_axis_];
+    while(true) {
+      size_t target{0};
+      for(size_t iDim=0; iDim<nDims; ++iDim) {
+        target = target * slice_dims_[iDim].bases_.size() + slice_dims_[iDim].lookup_indices_[current[iDim]];
+      }
+      sumw[target*scan_n_bins_*proj_n_bins_ + scanProjBin] += contents[iBin];
+      sumw2[target*scan_n_bins_*proj_n_bins_ + scanProjBin] += err2s[iBin];
+
+      int iDim = static_cast<int>(nDims) - 1;
+      for(; iDim>=0; --iDim) {
+        if(++current[iDim] < to[iDim]) break;
+        current[iDim] = from[iDim];
+      }
+      if(iDim < 0) break;
+    }
+  }
+}
+
+void THnSparseProjector::ConvertToSuffixSums() {
+  if(scan_n_bins_ == 1) return;
+
+  const size_t nTargets = sumw_.size() / scan_n_bins_ / proj_n_bins_;
+  for(size_t iTarget=0; iTarget<nTargets; ++iTarget) {
+    double* w = &sumw_[iTarget*scan_n_bins_*proj_n_bins_];
+    double* w2 = &sumw2_[iTarget*scan_n_bins_*proj_n_bins_];
+    for(int iScan=scan_n_bins_-2; iScan>=0; --iScan) {
+      for(int iProj=0; iProj<proj_n_bins_; ++iProj) {
+        w[iScan*proj_n_bins_ + iProj] += w[(iScan+1)*proj_n_bins_ + iProj];
+        w2[iScan*proj_n_bins_ + iProj] += w2[(iScan+1)*proj_n_bins_ + iProj];
+      }
+    }
+  }
+}
+
+TH1D* THnSparseProjector::GetProjection(const std::vector<size_t>& iSlices) const {
+  if(!is_run_) throw std::runtime_error("THnSparseProjector::GetProjection(): Run() was not called");
+  if(iSlices.size() != slice_dims_.size()) throw std::runtime_error("THnSparseProjector::GetProjection(): iSlices.size() != number of slice dimensions");
+
+  size_t target{0};
+  std::pair<int, int> scanRange{0, scan_n_bins_-1};
+  for(size_t iDim=0; iDim<slice_dims_.size(); ++iDim) {
+    const auto& dim = slice_dims_.at(iDim);
+    if(iSlices.at(iDim) >= dim.selection_base_.size()) throw std::runtime_error("THnSparseProjector::GetProjection(): slice index is out of range");
+    target = target * dim.bases_.size() + dim.selection_base_.at(iSlices.at(iDim));
+    const auto& selScan = dim.selection_scan_.at(iSlices.at(iDim));
+    scanRange = {std::max(scanRange.first, selScan.first), std::min(scanRange.second, selScan.second)};
+  }
+
+  const TAxis* axis = histo_in_->GetAxis(proj_axis_);
+  const std::string name = static_cast<std::string>(histo_in_->GetName()) + "_proj_" + std::to_string(proj_axis_);
+  const std::string title = static_cast<std::string>(histo_in_->GetTitle()) + " projection " + axis->GetTitle();
+
+  TH1D* histo = axis->GetXbins()->GetSize() > 0 ?
+                new TH1D(name.c_str(), title.c_str(), axis->GetNbins(), axis->GetXbins()->GetArray()) :
+                new TH1D(name.c_str(), title.c_str(), axis->GetNbins(), axis->GetXmin(), axis->GetXmax());
+  histo->SetDirectory(nullptr);
+  histo->GetXaxis()->SetTitle(axis->GetTitle());
+  // weighting implies Sumw2, as in ScaleTHnSparseWithWeight()
+  const bool hasErrors = histo_in_->GetCalculateErrors() || view_.IsWeighted();
+  if(hasErrors) histo->Sumw2();
+  if(scanRange.first > scanRange.second) return histo; // scan ranges of the slices do not overlap
+
+  // the range along the scan axis is the difference of suffix sums; without scan axis the only "scan bin" is 0
+  const size_t offsetFrom = (target*scan_n_bins_ + scanRange.first) * proj_n_bins_;
+  const size_t offsetTo = (target*scan_n_bins_ + scanRange.second + 1) * proj_n_bins_;
+  const bool isSubtract = scanRange.second + 1 < scan_n_bins_;
+  for(int iBin=0; iBin<proj_n_bins_; ++iBin) {
+    const double w = sumw_.at(offsetFrom + iBin) - (isSubtract ? sumw_.at(offsetTo + iBin) : 0.);
+    const double w2 = sumw2_.at(offsetFrom + iBin) - (isSubtract ? sumw2_.at(offsetTo + iBin) : 0.);
+    histo->SetBinContent(iBin, w);
+    if(hasErrors) histo->SetBinError(iBin, std::sqrt(std::max(w2, 0.)));
+  }
+  histo->ResetStats();
+
+  return histo;
+}
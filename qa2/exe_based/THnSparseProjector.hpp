@@ -0,0 +1,111 @@
+#ifndef QA2_THNSPARSEPROJECTOR_HPP
+#define QA2_THNSPARSEPROJECTOR_HPP
+
+#include <TH1.h>
+#include <THnSparse.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Read-only view of a THnSparse, optionally weighted: content and error of each bin are scaled by the weight
+/// of its bin along one axis. It is equivalent to HelperGeneral::ScaleTHnSparseWithWeight() applied to a clone,
+/// but the weight is applied on the fly, so that the clone is never materialised.
+struct THnSparseWeightedView {
+  THnSparseWeightedView(const THnSparse* histo) : histo_(histo) {}
+  THnSparseWeightedView(const THnSparse* histo, int axis, const TH1* histoWeight);
+
+  bool IsWeighted() const { return axis_ >= 0; }
+  double GetWeight(const int* coords) const { return IsWeighted() ? weights_[coords[axis_]] : 1.; }
+
+  const THnSparse* histo_{nullptr};
+  int axis_{-1};
+  std::vector<double> weights_{}; // per axis bin, incl. under- and overflow
+};
+
+/// Builds many 1D projections of a THnSparse in a single pass over its filled bins.
+/// Each projection is a combination of slices: one selection from every slice dimension.
+/// A selection is a set of axis ranges (the same value-space convention as HelperGeneral::SetTHnSparseAxisRanges),
+/// an empty selection accepts everything. The result of each projection equals the one of THnSparse::Projection()
+/// with the corresponding axis ranges set, but neither axis ranges of the input histogram are touched,
+/// nor the filled bins are iterated over more than once.
+/// Optionally one axis can be declared as a scan axis (e.g. a BDT score scanned with "score > threshold" cuts).
+/// The cuts on it are then not sliced: the content is kept dense along the scan axis and converted into suffix sums
+/// (together with the sum of weights squared) after the pass, so that any range on the scan axis is read out as
+/// a difference of two suffix sums, and all the threshold projections cost as much as a single one.
+/// The pass can be shared between several threads, see SetNThreads().
+class THnSparseProjector {
+ public:
+  struct AxisCut {
+    int axis_;
+    float lo_;
+    float hi_;
+  };
+  using Selection = std::vector<AxisCut>;
+
+  THnSparseProjector() = delete;
+  THnSparseProjector(const THnSparseWeightedView& histo, int projAxis);
+  virtual ~THnSparseProjector() = default;
+
+  /// Must be called before adding slice dimensions
+  void SetScanAxis(int axis);
+
+  /// If false, the cuts on the scan axis are sliced as on any other axis instead of being read out of the suffix sums
+  /// (the result is the same, only the cost differs). True by default; must be called before adding slice dimensions
+  void SetUseScanSuffixSums(bool value);
+
+  /// Adds a slice dimension and returns its index
+  size_t AddSliceDimension(const std::vector<Selection>& selections);
+
+  /// Number of threads used in Run(); the result does not depend on the scheduling, but does (within the floating
+  /// point precision) on the number of threads, because the summation order changes
+  void SetNThreads(int nThreads);
+
+  void Run();
+
+  /// iSlices - selection index in each of the slice dimensions, in the order of their adding.
+  /// Neither the projector nor the input histogram is modified, so after Run() it can be called concurrently
+  /// (provided ROOT::EnableThreadSafety() for the creation of histograms)
+  TH1D* GetProjection(const std::vector<size_t>& iSlices) const;
+
+ private:
+  struct AxisBinCut {
+    int axis_;
+    int bin_lo_;
+    int bin_hi_;
+  };
+
+  struct SliceDimension {
+    std::vector<std::vector<AxisBinCut>> bases_;       // selections' cuts on axes other than the scan one, without duplicates
+    std::vector<size_t> selection_base_;               // index of selection's base
+    std::vector<std::pair<int, int>> selection_scan_;  // selection's bin range along the scan axis
+    std::vector<int> axes_;              // axes involved in the bases
+    std::vector<size_t> axes_strides_;   // strides of the axes' bins (incl. under- and overflow) in the lookup table
+    std::vector<size_t> lookup_offsets_; // CSR-like lookup table: for each combination of the axes' bins
+    std::vector<size_t> lookup_indices_; // the list of bases which accept it
+  };
+
+  void BuildLookupTable(SliceDimension& dim) const;
+  size_t GetLookupCell(const SliceDimension& dim, const int* coords) const;
+  void AccumulateBins(const int* coords, const double* contents, const double* err2s, size_t nBins, double* sumw, double* sumw2) const;
+  void ApplyScanAxis();
+  void ConvertToSuffixSums();
+
+  const THnSparse* histo_in_{nullptr};
+  THnSparseWeightedView view_;
+  int proj_axis_{-1};
+  int proj_n_bins_{-1}; // incl. under- and overflow
+  int scan_axis_requested_{-1}; // the one set with SetScanAxis()
+  bool is_use_scan_suffix_sums_{true};
+  int scan_axis_{-1};  // the one in use, -1 if the scan axis is not set or the suffix sums are switched off
+  int scan_n_bins_{1}; // incl. under- and overflow; 1 if no scan axis
+
+  std::vector<SliceDimension> slice_dims_;
+
+  std::vector<double> sumw_;
+  std::vector<double> sumw2_;
+  int n_threads_{1};
+  bool is_run_{false};
+};
+
+#endif //QA2_THNSPARSEPROJECTOR_HPP
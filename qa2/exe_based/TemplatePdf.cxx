@@ -0,0 +1,67 @@
+#include "TemplatePdf.h"
+
+#include <stdexcept>
+#include <string>
+
+ClassImp(TemplatePdf);
+
+TemplatePdf::TemplatePdf(const char* name, const char* title, RooAbsReal& x, const TH1* histoTemplate, Int_t nSmooth) : RooAbsPdf(name, title),
+                                                                                                                      mX("x", "observable", this, x),
+                                                                                                                      mNSmooth(nSmooth)
+{
+  if (histoTemplate == nullptr) {
+    throw std::runtime_error("TemplatePdf::TemplatePdf(): histoTemplate == nullptr");
+  }
+  // the template may be of any TH1 type (e.g. TH1F), so it is not Copy()-ed into the TH1D, but refilled bin by bin
+  const TAxis* axis = histoTemplate->GetXaxis();
+  const Int_t nBins = axis->GetNbins();
+  mHistoTemplate.SetName(histoTemplate->GetName());
+  mHistoTemplate.SetTitle(histoTemplate->GetTitle());
+  if (axis->GetXbins()->GetSize() == nBins + 1) {
+    mHistoTemplate.SetBins(nBins, axis->GetXbins()->GetArray());
+  } else {
+    mHistoTemplate.SetBins(nBins, axis->GetXmin(), axis->GetXmax());
+  }
+  mHistoTemplate.SetDirectory(nullptr);
+  mHistoTemplate.Sumw2();
+  for (Int_t iBin = 0; iBin <= nBins + 1; ++iBin) {
+    mHistoTemplate.SetBinContent(iBin, histoTemplate->GetBinContent(iBin));
+    mHistoTemplate.SetBinError(iBin, histoTemplate->GetBinError(iBin));
+  }
+  mHistoTemplate.SetEntries(histoTemplate->GetEntries());
+}
+
+TemplatePdf::TemplatePdf(const TemplatePdf& other, const char* name) : RooAbsPdf(other, name),
+                                                                       mX("x", this, other.mX),
+                                                                       mHistoTemplate(other.mHistoTemplate),
+                                                                       mNSmooth(other.mNSmooth),
+                                                                       mTable(other.mTable)
+{
+  mHistoTemplate.SetDirectory(nullptr);
+}
+
+const TemplateTable& TemplatePdf::getTable() const
+{
+  if (mTable == nullptr) {
+    mTable = TemplateTable::Get(&mHistoTemplate, mNSmooth, true);
+  }
+  return *mTable;
+}
+
+Double_t TemplatePdf::evaluate() const
+{
+  return getTable().Evaluate(mX);
+}
+
+Int_t TemplatePdf::getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* /*rangeName*/) const
+{
+  return matchArgs(allVars, analVars, mX) ? 1 : 0;
+}
+
+Double_t TemplatePdf::analyticalIntegral(Int_t code, const char* rangeName) const
+{
+  if (code != 1) {
+    throw std::runtime_error("TemplatePdf::analyticalIntegral(): unsupported integration code " + std::to_string(code));
+  }
+  return getTable().Integral(mX.min(rangeName), mX.max(rangeName));
+}
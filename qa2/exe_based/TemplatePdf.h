@@ -0,0 +1,43 @@
+#ifndef QA2_TEMPLATEPDF_H
+#define QA2_TEMPLATEPDF_H
+
+#include "TemplateTable.hpp"
+
+#include <RooAbsPdf.h>
+#include <RooAbsReal.h>
+#include <RooRealProxy.h>
+#include <TH1D.h>
+
+#include <memory>
+
+/// Pdf of a histogram template (e.g. the correlated background): its density linearly interpolated between the bin centres,
+/// as RooHistPdf with intOrder = 1.
+/// Unlike RooHistPdf it neither searches the bin nor rebuilds the interpolation per call: the shape is tabulated
+/// once (TemplateTable, shared between all pdfs of the same template), and the normalisation integral over any
+/// range is analytical.
+class TemplatePdf : public RooAbsPdf
+{
+ public:
+  TemplatePdf() = default;
+  TemplatePdf(const char* name, const char* title, RooAbsReal& x, const TH1* histoTemplate, Int_t nSmooth = 0);
+  TemplatePdf(const TemplatePdf& other, const char* name = nullptr);
+  TObject* clone(const char* newname) const override { return new TemplatePdf(*this, newname); }
+
+  Int_t getAnalyticalIntegral(RooArgSet& allVars, RooArgSet& analVars, const char* rangeName = nullptr) const override;
+  Double_t analyticalIntegral(Int_t code, const char* rangeName = nullptr) const override;
+
+ protected:
+  Double_t evaluate() const override;
+
+ private:
+  const TemplateTable& getTable() const;
+
+  RooRealProxy mX;
+  TH1D mHistoTemplate; /// template histogram, kept for the persistency of the pdf
+  Int_t mNSmooth{0};   /// number of TH1::Smooth() iterations applied to the template
+  mutable std::shared_ptr<const TemplateTable> mTable; //! tabulated template, built on the first use
+
+  ClassDefOverride(TemplatePdf, 1);
+};
+
+#endif //QA2_TEMPLATEPDF_H
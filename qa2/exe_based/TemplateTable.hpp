@@ -0,0 +1,137 @@
+#ifndef QA2_TEMPLATETABLE_HPP
+#define QA2_TEMPLATETABLE_HPP
+
+#include <TH1.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Template shape tabulated once from a histogram: piecewise-linear interpolation between the bin centres
+/// (flat between the outer centres and the histogram edges, zero outside), with the exact cumulative integral
+/// precomputed at the centres. Both the value and the integral over any range cost O(1) for a uniform binning
+/// (O(log nBins) otherwise), instead of a bin search per call or a numerical integration.
+/// The values are in the units of the bin contents, or of the bin contents over the bin widths with isDensity
+/// (as in RooHistPdf, which matters for a variable binning), not normalised. The optional smoothing (TH1::Smooth()) is
+/// applied once when the table is built. Get() shares the tables by a hash of the histogram and the smoothing,
+/// so that a template used in many fits (e.g. all the BDT thresholds) is smoothed and tabulated once per process.
+/// Header-only, so that it can be used from the ROOT macros as well.
+class TemplateTable {
+ public:
+  explicit TemplateTable(const TH1* histo, int nSmooth=0, bool isDensity=false) {
+    if(histo == nullptr) throw std::runtime_error("TemplateTable::TemplateTable(): histo == nullptr");
+
+    std::unique_ptr<TH1> histoSmoothed;
+    if(nSmooth > 0) {
+      histoSmoothed.reset(dynamic_cast<TH1*>(histo->Clone()));
+      histoSmoothed->SetDirectory(nullptr);
+      histoSmoothed->Smooth(nSmooth);
+      histo = histoSmoothed.get();
+    }
+
+    const int nBins = histo->GetNbinsX();
+    x_lo_ = histo->GetBinLowEdge(1);
+    x_hi_ = histo->GetBinLowEdge(nBins + 1);
+    for(int iBin = 1; iBin <= nBins; iBin++) {
+      x_.push_back(histo->GetBinCenter(iBin));
+      y_.push_back(isDensity ? histo->GetBinContent(iBin) / histo->GetBinWidth(iBin) : histo->GetBinContent(iBin));
+    }
+
+    step_ = nBins > 1 ? (x_.back() - x_.front()) / (nBins - 1) : 0.;
+    is_uniform_ = true;
+    for(int i = 1; i < nBins; i++) {
+      if(std::abs(x_.at(i) - x_.at(i - 1) - step_) > 1e-9 * std::abs(step_)) is_uniform_ = false;
+    }
+
+    cumulative_.resize(nBins);
+    cumulative_.at(0) = y_.at(0) * (x_.at(0) - x_lo_);
+    for(int i = 1; i < nBins; i++) {
+      cumulative_.at(i) = cumulative_.at(i - 1) + (y_.at(i - 1) + y_.at(i)) / 2 * (x_.at(i) - x_.at(i - 1));
+    }
+  }
+
+  /// Shared table of the histogram; the histogram is identified by its binning and contents, not by the pointer
+  static std::shared_ptr<const TemplateTable> Get(const TH1* histo, int nSmooth=0, bool isDensity=false) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const TemplateTable>> tables;
+
+    const std::string key = MakeKey(histo, nSmooth, isDensity);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& table = tables[key];
+    if(table == nullptr) table = std::make_shared<const TemplateTable>(histo, nSmooth, isDensity);
+    return table;
+  }
+
+  double Evaluate(double x) const {
+    if(x < x_lo_ || x > x_hi_) return 0.;
+    if(x <= x_.front()) return y_.front();
+    if(x >= x_.back()) return y_.back();
+    const size_t i = FindSegment(x);
+    const double t = (x - x_.at(i)) / (x_.at(i + 1) - x_.at(i));
+    return y_.at(i) + t * (y_.at(i + 1) - y_.at(i));
+  }
+
+  /// Integral of Evaluate() from lo to hi
+  double Integral(double lo, double hi) const { return Primitive(hi) - Primitive(lo); }
+
+  double GetXmin() const { return x_lo_; }
+  double GetXmax() const { return x_hi_; }
+
+ private:
+  size_t FindSegment(double x) const {
+    const size_t nSegments = x_.size() - 1;
+    if(is_uniform_) return std::min(static_cast<size_t>((x - x_.front()) / step_), nSegments - 1);
+    return std::min(static_cast<size_t>(std::upper_bound(x_.begin(), x_.end(), x) - x_.begin()) - 1, nSegments - 1);
+  }
+
+  // integral of Evaluate() from x_lo_ to x
+  double Primitive(double x) const {
+    x = std::clamp(x, x_lo_, x_hi_);
+    if(x <= x_.front()) return y_.front() * (x - x_lo_);
+    if(x >= x_.back()) return cumulative_.back() + y_.back() * (x - x_.back());
+    const size_t i = FindSegment(x);
+    const double t = x - x_.at(i);
+    return cumulative_.at(i) + y_.at(i) * t + (y_.at(i + 1) - y_.at(i)) * t * t / (2 * (x_.at(i + 1) - x_.at(i)));
+  }
+
+  // FNV-1a hash of the binning, the contents, the smoothing and the density flag
+  static std::string MakeKey(const TH1* histo, int nSmooth, bool isDensity) {
+    if(histo == nullptr) throw std::runtime_error("TemplateTable::MakeKey(): histo == nullptr");
+    uint64_t hash{14695981039346656037ULL};
+    auto add = [&hash](double value) {
+      unsigned char bytes[sizeof(double)];
+      std::memcpy(bytes, &value, sizeof(double));
+      for(const auto byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ULL;
+      }
+    };
+    const int nBins = histo->GetNbinsX();
+    add(nBins);
+    add(nSmooth);
+    add(isDensity);
+    for(int iBin = 1; iBin <= nBins; iBin++) {
+      add(histo->GetBinLowEdge(iBin));
+      add(histo->GetBinContent(iBin));
+    }
+    add(histo->GetBinLowEdge(nBins + 1));
+    return std::to_string(hash);
+  }
+
+  std::vector<double> x_;          // bin centres
+  std::vector<double> y_;          // bin contents (or densities)
+  std::vector<double> cumulative_; // integral from x_lo_ to each bin centre
+  double x_lo_{0.};
+  double x_hi_{0.};
+  double step_{0.};
+  bool is_uniform_{true};
+};
+
+#endif //QA2_TEMPLATETABLE_HPP
@@ -0,0 +1,90 @@
+#ifndef QA2_BENCHMARKHELPER_HPP
+#define QA2_BENCHMARKHELPER_HPP
+
+#include <TFile.h>
+#include <TH1D.h>
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimal timing for the benchmark executables: the median wall time of several repetitions
+namespace BenchmarkHelper {
+/// setup() is called before each repetition and is not timed
+inline double MedianSeconds(const std::function<void()>& func, int nRepeats, const std::function<void()>& setup=[](){}) {
+  std::vector<double> times;
+  for(int iRepeat=0; iRepeat<nRepeats; ++iRepeat) {
+    setup();
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto stop = std::chrono::steady_clock::now();
+    times.emplace_back(std::chrono::duration<double>(stop - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times.at(times.size() / 2);
+}
+
+inline void Report(const std::string& name, double seconds, double referenceSeconds) {
+  std::cout << std::left << std::setw(48) << name << std::right << std::fixed << std::setprecision(4)
+            << std::setw(12) << seconds << " s" << std::setprecision(2) << std::setw(10) << referenceSeconds / seconds << "x\n";
+}
+
+/// Lambda_c-like invariant-mass spectrum: a Gaussian peak over a linear background, the caller owns the histogram
+inline TH1D* MakeMassSpectrum(const std::string& name, int nSignal, int nBackground, unsigned int seed, double mean=2.286, double sigma=0.008) {
+  TRandom3 random(seed);
+  auto histo = new TH1D(name.c_str(), ";#it{M} (GeV/#it{c}^{2});counts", 300, 2.12, 2.42);
+  histo->SetDirectory(nullptr);
+  histo->Sumw2();
+  for(int iEntry=0; iEntry<nSignal; ++iEntry) {
+    histo->Fill(random.Gaus(mean, sigma));
+  }
+  for(int iEntry=0; iEntry<nBackground; ++iEntry) {
+    // linear slope by the rejection sampling
+    double mass;
+    do {
+      mass = random.Uniform(2.12, 2.42);
+    } while(random.Uniform() > 1. - 1.5 * (mass - 2.12));
+    histo->Fill(mass);
+  }
+  return histo;
+}
+
+/// JSON array of value(i) for i in [0, nValues), for the configs written by the benchmarks
+inline std::string JsonArray(int nValues, const std::function<std::string(int)>& value) {
+  std::stringstream stream;
+  stream << "[";
+  for(int iValue=0; iValue<nValues; ++iValue) {
+    stream << (iValue == 0 ? "" : ", ") << value(iValue);
+  }
+  stream << "]";
+  return stream.str();
+}
+
+inline std::string JsonArray(int nValues, const std::string& value) {
+  return JsonArray(nValues, [&value](int) { return value; });
+}
+
+/// Histogram histoName of the file fileName, e.g. a saved mass spectrum to run a benchmark on the real data; the caller owns it
+inline TH1* ReadHistogram(const std::string& fileName, const std::string& histoName) {
+  std::unique_ptr<TFile> file(TFile::Open(fileName.c_str(), "read"));
+  if(file == nullptr || file->IsZombie()) throw std::runtime_error("BenchmarkHelper::ReadHistogram(): cannot open " + fileName);
+  auto histo = file->Get<TH1>(histoName.c_str());
+  if(histo == nullptr) throw std::runtime_error("BenchmarkHelper::ReadHistogram(): no " + histoName + " in " + fileName);
+  histo->SetDirectory(nullptr);
+  return histo;
+}
+
+inline int IntArgument(int argc, char** argv, int position, int defaultValue) {
+  return argc > position ? std::stoi(argv[position]) : defaultValue;
+}
+} // namespace BenchmarkHelper
+
+#endif //QA2_BENCHMARKHELPER_HPP
@@ -0,0 +1,57 @@
+#include "BenchmarkHelper.hpp"
+#include "HFInvMassFitter.h"
+
+#include <RooMsgService.h>
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Time of a single HFInvMassFitter::doFit() (Poly2 background + Gaussian, chi2 and likelihood) with each of the RooFit
+// evaluation backends and MINUIT strategies, together with the fit status and the raw yield, so that the speed-up
+// is read alongside the agreement of the results. The unavailable backends (e.g. codegen without clad) are reported.
+// The spectrum is a synthetic one with nSignal signal entries, or the histogram histoName of the file fileName if given.
+// Usage: bench_fit_backends [nSignal=20000] [nRepeats=5] [fileName histoName]
+int main(int argc, char** argv) {
+  const int nSignal = BenchmarkHelper::IntArgument(argc, argv, 1, 20000);
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 2, 5);
+  const bool isRealInput = argc > 4;
+  RooMsgService::instance().setGlobalKillBelow(RooFit::WARNING);
+
+  std::unique_ptr<TH1> histo(isRealInput ? BenchmarkHelper::ReadHistogram(argv[3], argv[4]) :
+                                           BenchmarkHelper::MakeMassSpectrum("hMass", nSignal, 20 * nSignal, 1));
+  for(const bool isLikelihood : {false, true}) {
+    double referenceTime{0.};
+    for(const std::string backend : {"legacy", "cpu", "codegen"}) {
+      for(const int strategy : {0, 1, 2}) {
+        const std::string name = std::string(isLikelihood ? "likelihood" : "chi2") + ", " + backend + ", strategy " + std::to_string(strategy);
+        std::unique_ptr<HFInvMassFitter> fitter;
+        auto setup = [&]() {
+          fitter = std::make_unique<HFInvMassFitter>(histo.get(), 2.12, 2.42, HFInvMassFitter::Poly2, HFInvMassFitter::SingleGaus);
+          fitter->setHeadless(true);
+          fitter->setEvalBackend(backend);
+          fitter->setFitStrategy(strategy);
+          fitter->setInitialGaussianMean(2.286);
+          fitter->setInitialGaussianSigma(0.01);
+          if(isLikelihood) fitter->setUseLikelihoodFit();
+          else             fitter->setUseChi2Fit();
+        };
+        double time;
+        try {
+          time = BenchmarkHelper::MedianSeconds([&]() { fitter->doFit(); }, nRepeats, setup);
+        } catch(const std::exception& e) {
+          std::cout << name << ": unavailable (" << e.what() << ")\n";
+          continue;
+        }
+        if(referenceTime == 0.) referenceTime = time;
+        BenchmarkHelper::Report(name, time, referenceTime);
+        std::cout << "    status " << fitter->getFitStatus() << ", raw yield " << fitter->getRawYield() << " +- " << fitter->getRawYieldError();
+        if(!isRealInput) std::cout << " (true " << nSignal << ")";
+        std::cout << "\n";
+      }
+    }
+  }
+
+  return 0;
+}
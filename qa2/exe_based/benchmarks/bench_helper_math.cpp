@@ -0,0 +1,83 @@
+#include "BenchmarkHelper.hpp"
+#include "HelperMath.hpp"
+
+#include <TF1.h>
+#include <TH1D.h>
+#include <TRandom3.h>
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Time of the HelperMath histogram operations on plain TH1D histograms with Sumw2: the generic per-bin path
+// (HelperMath::SetUseFastPaths(false), the reference) vs the direct-array kernels.
+// Usage: bench_helper_math [nBins=100000] [nRepeats=20]
+namespace {
+TH1D* MakeHisto(const std::string& name, int nBins, unsigned int seed) {
+  TRandom3 random(seed);
+  auto histo = new TH1D(name.c_str(), "", nBins, 0., 10.);
+  histo->Sumw2();
+  for(int iBin=0; iBin<=nBins+1; ++iBin) {
+    const double content = random.Uniform(100., 200.);
+    histo->SetBinContent(iBin, content);
+    histo->SetBinError(iBin, std::sqrt(content));
+  }
+  histo->ResetStats();
+  return histo;
+}
+
+/// setup() creates the inputs, operation() is timed, both with the fast paths and without
+void Run(const std::string& name, int nRepeats, const std::function<void()>& setup, const std::function<void()>& operation) {
+  double referenceTime{0.};
+  for(const bool isFast : {false, true}) {
+    HelperMath::SetUseFastPaths(isFast);
+    const double time = BenchmarkHelper::MedianSeconds(operation, nRepeats, setup);
+    if(!isFast) referenceTime = time;
+    BenchmarkHelper::Report(name + (isFast ? " fast" : " generic"), time, referenceTime);
+  }
+  HelperMath::SetUseFastPaths(true);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  const int nBins = BenchmarkHelper::IntArgument(argc, argv, 1, 100000);
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 2, 20);
+  TH1::AddDirectory(false);
+  std::cout << nBins << " bins, the median of " << nRepeats << " repetitions\n";
+
+  TF1 func("func", "pol1", 0., 10.);
+  func.SetParameters(150., 1.);
+
+  std::unique_ptr<TH1> histo;
+  std::unique_ptr<TH1> other;
+  std::unique_ptr<TH1> result;
+  std::unique_ptr<TH1> result2;
+  auto setupOne = [&]() { histo.reset(MakeHisto("h", nBins, 1)); };
+  auto setupTwo = [&]() {
+    setupOne();
+    other.reset(MakeHisto("hOther", nBins, 2));
+    other->Scale(0.5); // a subset, for the efficiency
+  };
+
+  Run("EvalNormDifferenceHistoFromFunction", nRepeats, setupOne, [&]() { HelperMath::EvalNormDifferenceHistoFromFunction(histo.get(), &func); });
+  Run("InvertHisto", nRepeats, setupOne, [&]() { HelperMath::InvertHisto(histo.get()); });
+  Run("EvaluateEfficiencyHisto", nRepeats, setupTwo, [&]() {
+    auto [hEff, hRelErr] = HelperMath::EvaluateEfficiencyHisto(other.get(), histo.get());
+    result.reset(hEff);
+    result2.reset(hRelErr);
+  });
+  Run("CutSubHistogram", nRepeats, setupOne, [&]() { result.reset(HelperMath::CutSubHistogram(histo.get(), 1., 9.)); });
+
+  std::vector<std::unique_ptr<TH1>> addends;
+  std::vector<TH1*> addendPtrs;
+  for(int iAddend=0; iAddend<10; ++iAddend) {
+    addends.emplace_back(MakeHisto("hAddend" + std::to_string(iAddend), nBins, 10 + iAddend));
+    addendPtrs.emplace_back(addends.back().get());
+  }
+  Run("MergeHistograms of 10", nRepeats, [](){}, [&]() { result.reset(HelperMath::MergeHistograms(addendPtrs)); });
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "BenchmarkHelper.hpp"
+
+#include <TF1.h>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TRandom3.h>
+#include <TSystem.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// Wall time of the runMassFitter executable in the batch mode over nThresholds neighbouring BDT thresholds of a synthetic
+// Lambda_c spectrum, with the cold-started fits (WarmStart false, the default) and with the warm-started ones (WarmStart true).
+// The function calls saved by the warm start are printed by runMassFitter itself.
+// Usage: bench_mass_fitter_warm_start [nSlices=4] [nThresholds=20] [nRepeats=3]
+namespace {
+const std::string kInputFileName = "bench_mass_fitter_warm_start_input.root";
+const std::string kConfigFileName = "bench_mass_fitter_warm_start_config.json";
+const std::string kOutputFileName = "bench_mass_fitter_warm_start_output_THRESHOLD.root";
+const std::string kLogFileName = "bench_mass_fitter_warm_start.log";
+
+std::string ThresholdName(int iThreshold) {
+  std::stringstream stream;
+  stream << std::fixed << std::setprecision(2) << 0.40 + 0.01 * iThreshold;
+  return stream.str();
+}
+
+/// the background falls and the signal stays almost the same with the threshold, as in a BDT scan
+void WriteInput(int nSlices, int nThresholds) {
+  TFile fileOut(kInputFileName.c_str(), "recreate");
+  TF1 spectrum("spectrum", "[0]*(1 - 0.5*(x-2.27)) + [1]*TMath::Gaus(x, 2.286, 0.008, true)", 2.1, 2.45);
+  gRandom->SetSeed(1);
+  for(int iSlice=0; iSlice<nSlices; ++iSlice) {
+    for(int iThreshold=0; iThreshold<nThresholds; ++iThreshold) {
+      spectrum.SetParameters(200. * (1. - 0.02 * iThreshold), 10. + 2.*iSlice);
+      TH1D histo(("hM_" + std::to_string(iSlice) + "_" + ThresholdName(iThreshold)).c_str(), "", 350, 2.1, 2.45);
+      histo.FillRandom("spectrum", static_cast<int>(100000 * (1. - 0.015 * iThreshold)));
+      histo.Write();
+    }
+  }
+  fileOut.Close();
+}
+
+void WriteConfig(int nSlices, int nThresholds, bool isWarmStart) {
+  using BenchmarkHelper::JsonArray;
+  std::ofstream config(kConfigFileName);
+  config << "{\n"
+         << "  \"IsMC\": false, \"InFileName\": \"" << kInputFileName << "\", \"ReflFileName\": \"\", \"OutFileName\": \"" << kOutputFileName << "\",\n"
+         << "  \"BatchPlaceholder\": \"THRESHOLD\", \"BatchValues\": " << JsonArray(nThresholds, [](int iThreshold) { return "\"" + ThresholdName(iThreshold) + "\""; }) << ",\n"
+         << "  \"WarmStart\": " << (isWarmStart ? "true" : "false") << ",\n"
+         << "  \"InputHistoName\": " << JsonArray(nSlices, [](int iSlice) { return "\"hM_" + std::to_string(iSlice) + "_THRESHOLD\""; }) << ",\n"
+         << "  \"PromptHistoName\": [], \"FDHistoName\": [], \"ReflHistoName\": [], \"PromptSecPeakHistoName\": [], \"FDSecPeakHistoName\": [],\n"
+         << "  \"Particle\": \"LcToPKPi\", \"EnableRefl\": false,\n"
+         << "  \"FixSigma\": false, \"SigmaFile\": \"\", \"FixSigmaManual\": [], \"FixMean\": false, \"MeanFile\": \"\", \"FixMeanManual\": [],\n"
+         << "  \"FixSecondSigma\": false, \"SecondSigmaFile\": \"\", \"FixSecondSigmaManual\": [],\n"
+         << "  \"SliceVarName\": \"T\", \"SliceVarUnit\": \"ps\",\n"
+         << "  \"SliceVarMin\": " << JsonArray(nSlices, [](int iSlice) { return std::to_string(iSlice); })
+         << ", \"SliceVarMax\": " << JsonArray(nSlices, [](int iSlice) { return std::to_string(iSlice + 1); }) << ",\n"
+         << "  \"MassMin\": " << JsonArray(nSlices, "2.12") << ", \"MassMax\": " << JsonArray(nSlices, "2.42") << ", \"Rebin\": " << JsonArray(nSlices, "1") << ",\n"
+         << "  \"InclSecPeak\": false, \"UseLikelihood\": false, \"BkgFunc\": " << JsonArray(nSlices, "2") << ", \"SgnFunc\": " << JsonArray(nSlices, "0") << ",\n"
+         << "  \"NWorkers\": 1, \"drawBgPrefit\": true, \"highlightPeakRegion\": true\n"
+         << "}\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  const int nSlices = BenchmarkHelper::IntArgument(argc, argv, 1, 4);
+  const int nThresholds = BenchmarkHelper::IntArgument(argc, argv, 2, 20);
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 3, 3);
+
+  WriteInput(nSlices, nThresholds);
+  const std::string command = std::string(RUN_MASS_FITTER) + " " + kConfigFileName + " > " + kLogFileName;
+  int status{0};
+  double referenceTime{0.};
+  for(const bool isWarmStart : {false, true}) {
+    WriteConfig(nSlices, nThresholds, isWarmStart);
+    const double time = BenchmarkHelper::MedianSeconds([&]() { status |= gSystem->Exec(command.c_str()); }, nRepeats);
+    if(!isWarmStart) referenceTime = time;
+    BenchmarkHelper::Report(std::to_string(nSlices) + " slices x " + std::to_string(nThresholds) + (isWarmStart ? " thresholds, warm" : " thresholds, cold"), time, referenceTime);
+  }
+  // the function calls of the last warm-started run
+  gSystem->Exec(("grep 'warm start:' " + kLogFileName).c_str());
+
+  for(const auto& fileName : {kInputFileName, kConfigFileName, kLogFileName}) {
+    gSystem->Unlink(fileName.c_str());
+  }
+  gSystem->Exec(("rm -f " + TString(kOutputFileName).ReplaceAll("THRESHOLD.root", "*")).Data());
+
+  return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include "BenchmarkHelper.hpp"
+
+#include <TF1.h>
+#include <TFile.h>
+#include <TH1D.h>
+#include <TRandom3.h>
+#include <TSystem.h>
+
+#include <fstream>
+#include <string>
+
+// Wall time of the runMassFitter executable fitting the slices of a synthetic Lambda_c spectrum
+// with NWorkers = 1, 2, 4 and 8 processes (see fitSlicesInWorkers() in runMassFitter.C).
+// Usage: bench_mass_fitter_workers [nSlices=8] [nRepeats=3]
+namespace {
+const std::string kInputFileName = "bench_mass_fitter_workers_input.root";
+const std::string kConfigFileName = "bench_mass_fitter_workers_config.json";
+const std::string kOutputFileName = "bench_mass_fitter_workers_output.root";
+
+void WriteInput(int nSlices) {
+  TFile fileOut(kInputFileName.c_str(), "recreate");
+  TF1 spectrum("spectrum", "[0]*(1 - 0.5*(x-2.27)) + [1]*TMath::Gaus(x, 2.286, 0.008, true)", 2.1, 2.45);
+  gRandom->SetSeed(1);
+  for(int iSlice=0; iSlice<nSlices; ++iSlice) {
+    spectrum.SetParameters(200., 10. + 2.*iSlice);
+    TH1D histo(("hM_" + std::to_string(iSlice)).c_str(), "", 350, 2.1, 2.45);
+    histo.FillRandom("spectrum", 100000);
+    histo.Write();
+  }
+  fileOut.Close();
+}
+
+void WriteConfig(int nSlices, int nWorkers) {
+  using BenchmarkHelper::JsonArray;
+  std::ofstream config(kConfigFileName);
+  config << "{\n"
+         << "  \"IsMC\": false, \"InFileName\": \"" << kInputFileName << "\", \"ReflFileName\": \"\", \"OutFileName\": \"" << kOutputFileName << "\",\n"
+         << "  \"InputHistoName\": " << JsonArray(nSlices, [](int iSlice) { return "\"hM_" + std::to_string(iSlice) + "\""; }) << ",\n"
+         << "  \"PromptHistoName\": [], \"FDHistoName\": [], \"ReflHistoName\": [], \"PromptSecPeakHistoName\": [], \"FDSecPeakHistoName\": [],\n"
+         << "  \"Particle\": \"LcToPKPi\", \"EnableRefl\": false,\n"
+         << "  \"FixSigma\": false, \"SigmaFile\": \"\", \"FixSigmaManual\": [], \"FixMean\": false, \"MeanFile\": \"\", \"FixMeanManual\": [],\n"
+         << "  \"FixSecondSigma\": false, \"SecondSigmaFile\": \"\", \"FixSecondSigmaManual\": [],\n"
+         << "  \"SliceVarName\": \"T\", \"SliceVarUnit\": \"ps\",\n"
+         << "  \"SliceVarMin\": " << JsonArray(nSlices, [](int iSlice) { return std::to_string(iSlice); })
+         << ", \"SliceVarMax\": " << JsonArray(nSlices, [](int iSlice) { return std::to_string(iSlice + 1); }) << ",\n"
+         << "  \"MassMin\": " << JsonArray(nSlices, "2.12") << ", \"MassMax\": " << JsonArray(nSlices, "2.42") << ", \"Rebin\": " << JsonArray(nSlices, "1") << ",\n"
+         << "  \"InclSecPeak\": false, \"UseLikelihood\": false, \"BkgFunc\": " << JsonArray(nSlices, "2") << ", \"SgnFunc\": " << JsonArray(nSlices, "0") << ",\n"
+         << "  \"NWorkers\": " << nWorkers << ", \"drawBgPrefit\": true, \"highlightPeakRegion\": true\n"
+         << "}\n";
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  const int nSlices = BenchmarkHelper::IntArgument(argc, argv, 1, 8);
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 2, 3);
+
+  WriteInput(nSlices);
+  const std::string command = std::string(RUN_MASS_FITTER) + " " + kConfigFileName + " > /dev/null";
+  int status{0};
+  double referenceTime{0.};
+  for(int nWorkers : {1, 2, 4, 8}) {
+    WriteConfig(nSlices, nWorkers);
+    const double time = BenchmarkHelper::MedianSeconds([&]() { status |= gSystem->Exec(command.c_str()); }, nRepeats);
+    if(nWorkers == 1) referenceTime = time;
+    BenchmarkHelper::Report(std::to_string(nSlices) + " slices with " + std::to_string(nWorkers) + " worker(s)", time, referenceTime);
+  }
+  for(const auto& fileName : {kInputFileName, kConfigFileName, kOutputFileName}) {
+    gSystem->Unlink(fileName.c_str());
+  }
+  gSystem->Exec(("rm -f " + TString(kOutputFileName).ReplaceAll(".root", "*.pdf")).Data());
+
+  return status == 0 ? 0 : 1;
+}
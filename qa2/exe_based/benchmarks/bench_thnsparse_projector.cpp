@@ -0,0 +1,71 @@
+#include "BenchmarkHelper.hpp"
+#include "THnSparseProjector.hpp"
+
+#include <TH1D.h>
+#include <TROOT.h>
+#include <TRandom3.h>
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+// Thread scaling of THnSparseProjector::Run() on a synthetic (mass, pT, BDT score, ct) THnSparse
+// with pT slices and a scan over the BDT score thresholds.
+// Usage: bench_thnsparse_projector [nEntries=2000000] [nRepeats=5]
+int main(int argc, char** argv) {
+  const int nEntries = BenchmarkHelper::IntArgument(argc, argv, 1, 2000000);
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 2, 5);
+  ROOT::EnableThreadSafety();
+
+  const int nBins[4] = {200, 20, 100, 20};
+  const double xMin[4] = {2.1, 0., 0., 0.};
+  const double xMax[4] = {2.5, 20., 1., 2.};
+  THnSparseD histo("histo", "", 4, nBins, xMin, xMax);
+  histo.Sumw2();
+  TRandom3 random(1);
+  for(int iEntry=0; iEntry<nEntries; ++iEntry) {
+    const double point[4] = {random.Uniform(2.1, 2.5), random.Exp(4.), random.Uniform(), random.Exp(0.5)};
+    histo.Fill(point);
+  }
+  std::cout << "filled bins: " << histo.GetNbins() << "\n";
+
+  std::vector<THnSparseProjector::Selection> ptSlices;
+  for(float ptLo : {0.f, 2.f, 4.f, 6.f, 8.f, 12.f}) {
+    ptSlices.push_back({{1, ptLo, ptLo + 2.f}});
+  }
+  std::vector<THnSparseProjector::Selection> bdtThresholds;
+  for(int iThreshold=0; iThreshold<50; ++iThreshold) {
+    bdtThresholds.push_back({{2, 0.02f * iThreshold, 1.f}});
+  }
+
+  double referenceTime{0.};
+  std::unique_ptr<TH1D> referenceProjection;
+  for(int nThreads : {1, 2, 4, 8}) {
+    std::unique_ptr<THnSparseProjector> projector;
+    auto setup = [&]() {
+      projector = std::make_unique<THnSparseProjector>(THnSparseWeightedView(&histo), 0);
+      projector->SetScanAxis(2);
+      projector->AddSliceDimension(ptSlices);
+      projector->AddSliceDimension(bdtThresholds);
+      projector->SetNThreads(nThreads);
+    };
+    const double time = BenchmarkHelper::MedianSeconds([&]() { projector->Run(); }, nRepeats, setup);
+    if(nThreads == 1) referenceTime = time;
+    BenchmarkHelper::Report("Run() with " + std::to_string(nThreads) + " thread(s)", time, referenceTime);
+
+    std::unique_ptr<TH1D> projection(projector->GetProjection({2, 25}));
+    if(referenceProjection == nullptr) {
+      referenceProjection = std::move(projection);
+      continue;
+    }
+    for(int iBin=0; iBin<=referenceProjection->GetNbinsX()+1; ++iBin) {
+      const double diff = std::fabs(projection->GetBinContent(iBin) - referenceProjection->GetBinContent(iBin));
+      if(diff > 1e-9 * std::max(1., referenceProjection->GetBinContent(iBin))) {
+        std::cout << "projection differs from the 1-thread one in bin " << iBin << "\n";
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
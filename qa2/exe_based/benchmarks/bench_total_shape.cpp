@@ -0,0 +1,88 @@
+#include "BenchmarkHelper.hpp"
+#include "ShapeFitter.hpp"
+#include "Shapes.hpp"
+
+#include <TF1.h>
+#include <TH1.h>
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Per-fit and per-evaluation time of the total (PolN + peak) function: the former definition, which selected the peak
+// shape by comparing the shape name on every evaluation ("before"), vs the TF1 defined by ShapeFitter, where the shape
+// is selected once ("after"). Both are fitted with TH1::Fit() from the same starting values to the same spectrum,
+// a synthetic one or the histogram histoName of the file fileName if given.
+// Usage: bench_total_shape [nRepeats=20] [fileName histoName]
+namespace {
+TF1* DefineAllBefore(const std::string& peakShape, const TF1* after) {
+  auto allShape = [peakShape] (const double* x, const double* par) {
+    if(peakShape == "Gaus") return PolN::Shape(x, par) + Gaus::Shape(x, &par[PolN::nPars]);
+    if(peakShape == "DoubleGaus") return PolN::Shape(x, par) + DoubleGaus::Shape(x, &par[PolN::nPars]);
+    if(peakShape == "DSCB") return PolN::Shape(x, par) + DoubleSidedCrystalBall::Shape(x, &par[PolN::nPars]);
+    throw std::runtime_error("DefineAllBefore() - peakShape must be one of the availables");
+  };
+  auto before = new TF1(("before_" + peakShape).c_str(), allShape, after->GetXmin(), after->GetXmax(), after->GetNpar());
+  for(int iPar=0; iPar<after->GetNpar(); iPar++) {
+    double lo, hi;
+    after->GetParLimits(iPar, lo, hi);
+    before->SetParLimits(iPar, lo, hi);
+  }
+  return before;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  const int nRepeats = BenchmarkHelper::IntArgument(argc, argv, 1, 20);
+
+  std::unique_ptr<TH1> histo(argc > 3 ? BenchmarkHelper::ReadHistogram(argv[2], argv[3]) :
+                                        BenchmarkHelper::MakeMassSpectrum("hMass", 20000, 400000, 1));
+  for(const std::string peakShape : {"Gaus", "DoubleGaus", "DSCB"}) {
+    ShapeFitter shapeFitter(histo.get());
+    shapeFitter.SetExpectedMu(2.286);
+    shapeFitter.SetExpectedSigma(0.008);
+    shapeFitter.SetSideBands(2.12, 2.20, 2.38, 2.42);
+    shapeFitter.SetPeakShape(peakShape);
+    shapeFitter.SetBgPolN(2);
+    shapeFitter.Fit();
+
+    std::unique_ptr<TF1> after(dynamic_cast<TF1*>(shapeFitter.GetAllReFunc()->Clone(("after_" + peakShape).c_str())));
+    std::unique_ptr<TF1> before(DefineAllBefore(peakShape, after.get()));
+    // the start is the converged result shifted by 2% in the free parameters
+    std::vector<double> start(after->GetParameters(), after->GetParameters() + after->GetNpar());
+    for(int iPar=0; iPar<after->GetNpar(); iPar++) {
+      double lo, hi;
+      after->GetParLimits(iPar, lo, hi);
+      if(lo == hi && lo != 0.) continue; // fixed
+      start.at(iPar) *= 1.02;
+    }
+
+    double referenceTime{0.};
+    for(TF1* func : {before.get(), after.get()}) {
+      const std::string name = peakShape + (func == before.get() ? " before" : " after");
+      const double timeFit = BenchmarkHelper::MedianSeconds([&]() { histo->Fit(func, "RS0Q"); }, nRepeats,
+                                                            [&]() { func->SetParameters(start.data()); });
+      if(func == before.get()) referenceTime = timeFit;
+      BenchmarkHelper::Report(name + ": fit", timeFit, referenceTime);
+      std::cout << "    chi2 / ndf = " << func->GetChisquare() << " / " << func->GetNDF() << "\n";
+    }
+
+    const int nEvaluations{1000000};
+    double sum{0.};
+    auto evaluate = [&](const TF1* func) {
+      const double step = (func->GetXmax() - func->GetXmin()) / nEvaluations;
+      for(int i=0; i<nEvaluations; i++) {
+        sum += func->Eval(func->GetXmin() + i * step);
+      }
+    };
+    const double timeBefore = BenchmarkHelper::MedianSeconds([&]() { evaluate(before.get()); }, nRepeats);
+    const double timeAfter = BenchmarkHelper::MedianSeconds([&]() { evaluate(after.get()); }, nRepeats);
+    BenchmarkHelper::Report(peakShape + " before: 10^6 evaluations", timeBefore, timeBefore);
+    BenchmarkHelper::Report(peakShape + " after: 10^6 evaluations", timeAfter, timeBefore);
+    if(sum == 0.) std::cout << "\n"; // keeps the evaluations from being optimised away
+  }
+
+  return 0;
+}
@@ -4,12 +4,14 @@
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
 #include "HelperPlot.hpp"
+#include "RawYieldStore.hpp"
 
 #include <TGraphErrors.h>
 #include <TH1.h>
 #include <TStyle.h>
 
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <utility>
 
@@ -20,7 +22,7 @@ using namespace HelperPlot;
 std::pair<double, double> EvaluateAverageExcludingOutliers(const std::vector<double>& values, const std::vector<double>& errors, double chi2Max = 1.);
 std::pair<double, double> EvaluateAverageExcludingOutliers(const TGraphErrors* graph, double from=-1e9, double to=1e9, double chi2Max=1.);
 
-void complex_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string& targetSignal, const std::string& wise){
+void complex_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string& targetSignal, const std::string& wise, const std::string& storeFileName){
   LoadMacro("styles/mc_qa2.style.cc");
   gStyle->SetMarkerSize(0.6);
   gStyle->SetNdivisions(315, "X");
@@ -49,8 +51,15 @@ void complex_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string
    "RawYieldsDscbNR"
   };
 
-  TFile* fileMarkup = OpenFileWithNullptrCheck(fileNameTemplate + "." + targetSignal + "gt" + to_string_with_precision(bdtScores.at(0), 2) + ".root");
-  TH1* histoMarkup = GetObjectWithNullptrCheck<TH1>(fileMarkup, "h" + variables.at(0));
+  // the results are read either from the single RawYieldStore, or from the file of each run
+  std::unique_ptr<RawYieldStore> store = storeFileName.empty() ? nullptr : std::make_unique<RawYieldStore>(storeFileName);
+  auto RunName = [&](double score) {
+    return fileNameTemplate + "." + targetSignal + "gt" + to_string_with_precision(score, 2);
+  };
+
+  const std::string runMarkup = RunName(bdtScores.at(0));
+  TFile* fileMarkup = store == nullptr ? OpenFileWithNullptrCheck(runMarkup + ".root") : nullptr;
+  TH1* histoMarkup = store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileMarkup, "h" + variables.at(0)) : store->GetHisto(runMarkup, "h" + variables.at(0));
   std::vector<float> lifeTimeRanges;
   for(int iBin=1; iBin<=histoMarkup->GetNbinsX()+1; ++iBin) {
     lifeTimeRanges.emplace_back(histoMarkup->GetBinLowEdge(iBin));
@@ -59,7 +68,9 @@ void complex_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string
   HelperMath::tensor2<TGraphErrors*> graphVar = HelperMath::make_tensor<TGraphErrors*, 2>({variables.size(), lifeTimeRanges.size()-1}, nullptr);
   int iExistingVar{0};
   for(int iVar=0, nVars=variables.size(); iVar<nVars; ++iVar) {
-    histoMarkup = fileMarkup->Get<TH1>(("h" + variables.at(iExistingVar)).c_str());
+    const std::string histoMarkupName = "h" + variables.at(iExistingVar);
+    if(store == nullptr) histoMarkup = fileMarkup->Get<TH1>(histoMarkupName.c_str());
+    else                 histoMarkup = store->Has(runMarkup, histoMarkupName) ? store->GetHisto(runMarkup, histoMarkupName) : nullptr;
     if(histoMarkup == nullptr) {
       variables.erase(variables.begin() + iExistingVar);
       continue;
@@ -75,19 +86,20 @@ void complex_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string
     } // lifeTimeRanges
     ++iExistingVar;
   } // variables
-  fileMarkup->Close();
+  if(fileMarkup != nullptr) fileMarkup->Close();
 
   for(const auto& score : bdtScores) {
-    TFile* fileIn = OpenFileWithNullptrCheck(fileNameTemplate + "." + targetSignal + "gt" + to_string_with_precision(score, 2) + ".root");
+    const std::string runName = RunName(score);
+    TFile* fileIn = store == nullptr ? OpenFileWithNullptrCheck(runName + ".root") : nullptr;
     for(int iVar=0, nVars=variables.size(); iVar<nVars; ++iVar) {
-      TH1* histoVar = GetObjectWithNullptrCheck<TH1>(fileIn, "h" + variables.at(iVar));
+      TH1* histoVar = store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileIn, "h" + variables.at(iVar)) : store->GetHisto(runName, "h" + variables.at(iVar));
       for(int iT=0, nTs=lifeTimeRanges.size()-1; iT<nTs; ++iT) {
         auto gra = graphVar.at(iVar).at(iT);
         gra->SetPoint(gra->GetN(), score, histoVar->GetBinContent(iT+1));
         gra->SetPointError(gra->GetN()-1, 0, histoVar->GetBinError(iT+1));
       } // lifetimeRanges
     } // variables
-    fileIn->Close();
+    if(fileIn != nullptr) fileIn->Close();
   } // bdtScores
 
   std::string priBra, ccName;
@@ -164,9 +176,10 @@ std::pair<double, double> EvaluateAverageExcludingOutliers(const TGraphErrors* g
 }
 
 int main(int argc, char* argv[]) {
+  const std::string storeFileName = ExtractStringOption(argc, argv, "--store", "");
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./complex_vs_bdt_pdfer fileNameTemplate (targetSignal=NP wise=var)" << std::endl;
+    std::cout << " ./complex_vs_bdt_pdfer fileNameTemplate (targetSignal=NP wise=var) (--store rawYieldStoreFileName)" << std::endl;
     exit(EXIT_FAILURE);
   }
 
@@ -176,7 +189,7 @@ int main(int argc, char* argv[]) {
   if(targetSignal != "P" && targetSignal != "NP") throw std::runtime_error("main(): targetSignal must be either 'P' or 'NP'");
   if(wise != "var" && wise != "T") throw std::runtime_error("main(): wise must be either 'var' or 'T'");
 
-  complex_vs_bdt_pdfer(fileNameTemplate, targetSignal, wise);
+  complex_vs_bdt_pdfer(fileNameTemplate, targetSignal, wise, storeFileName);
 
   return 0;
 }
@@ -4,6 +4,7 @@
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
 #include "HelperPlot.hpp"
+#include "OutputSink.hpp"
 
 #include <TFile.h>
 #include <TGraphErrors.h>
@@ -56,6 +57,17 @@ void efficiency_bdtcutset(const std::string& fileName) {
   const std::vector<std::string> weightPresences{"", "_W"};
 
   TFile* fileOut = TFile::Open((fileOutName + ".root").c_str(), "recreate");
+  OutputSink sink(fileOut);
+
+  // each per-score file is opened once and filled through its own sink
+  std::vector<TFile*> filesOutScore;
+  std::vector<OutputSink> sinksScore;
+  filesOutScore.reserve(bdtScores.size());
+  sinksScore.reserve(bdtScores.size());
+  for(const auto& score : bdtScores) {
+    filesOutScore.emplace_back(TFile::Open(("Eff_times_Acc_Lc." + tarSigShortcut + "gt" + to_string_with_precision(score, 2) + ".root").c_str(), "recreate"));
+    sinksScore.emplace_back(filesOutScore.back());
+  }
   HelperMath::tensor<TGraphErrors*, 4> grEff = make_tensor<TGraphErrors*, 4>({promptnesses.size(), weightPresences.size(), pTIntervals.size(), lifeTimeRanges.size()-1}, nullptr);
 
   auto PtRangeString = [] (const std::pair<double, double>& pTInterval) {
@@ -77,10 +89,11 @@ void efficiency_bdtcutset(const std::string& fileName) {
         TH1* histoGen = GetObjectWithNullptrCheck<TH1>(fileIn, "gen/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)) + "/hT" + weightPresences.at(iWeightPresence));
         RebinHistoToEdges(histoGen, lifeTimeRanges);
         histoGen->UseCurrentStyle();
-        CD(fileOut, "yields/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)));
-        histoGen->Write(("gen" + weightPresences.at(iWeightPresence)).c_str());
+        // histoGen is needed for all the scores, hence a copy goes to the sink
+        sink.Add("yields/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)), histoGen->Clone(), "gen" + weightPresences.at(iWeightPresence));
 
-        for (const auto& score: bdtScores) {
+        for (size_t iScore=0, nScores=bdtScores.size(); iScore<nScores; ++iScore) {
+          const float score = bdtScores.at(iScore);
           const std::string sScore = to_string_with_precision(score, 2);
           if(score == bdtScores.at(0)) std::cout << "Processing iLifeTimeRange ";
           for (size_t iLifeTimeRange = 0; iLifeTimeRange < lifeTimeRanges.size() - 1 && score == bdtScores.at(0); ++iLifeTimeRange) {
@@ -111,32 +124,29 @@ void efficiency_bdtcutset(const std::string& fileName) {
           RebinHistoToEdges(histoRec, lifeTimeRanges);
           histoRec->UseCurrentStyle();
 
-          CD(fileOut, "yields/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)));
-          histoRec->Write(("rec_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence)).c_str());
-
           auto [histoEff, histoEffRelErr] = EvaluateEfficiencyHisto(histoRec, histoGen);
 
-          CD(fileOut, "effs/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)));
-          histoEff->Write(("eff_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence)).c_str());
-
-          CD(fileOut, "errs/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)));
-          histoEffRelErr->Write(("err_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence)).c_str());
-
-          const std::string openOption = iPromptness + iPt + iWeightPresence == 0 ? "recreate" : "update";
-          TFile* fileOutScore = TFile::Open(("Eff_times_Acc_Lc." + tarSigShortcut + "gt" + sScore + ".root").c_str(), openOption.c_str());
-          CD(fileOutScore, PtRangeString(pTIntervals.at(iPt)));
-          histoEff->Write((promptness + weightPresences.at(iWeightPresence)).c_str());
           for (size_t iLifeTimeRange = 0; iLifeTimeRange < lifeTimeRanges.size() - 1; ++iLifeTimeRange) {
             auto gr = grEff.at(iPromptness).at(iWeightPresence).at(iPt).at(iLifeTimeRange);
             gr->SetPoint(gr->GetN(), score, histoEff->GetBinContent(iLifeTimeRange + 1));
             gr->SetPointError(gr->GetN() - 1, 0, histoEff->GetBinError(iLifeTimeRange + 1));
           }
-          fileOutScore->Close();
+
+          // the sinks own the histograms from now on
+          sink.Add("yields/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)), histoRec, "rec_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence));
+          sinksScore.at(iScore).Add(PtRangeString(pTIntervals.at(iPt)), histoEff->Clone(), promptness + weightPresences.at(iWeightPresence));
+          sink.Add("effs/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)), histoEff, "eff_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence));
+          sink.Add("errs/" + promptness + "/" + PtRangeString(pTIntervals.at(iPt)), histoEffRelErr, "err_" + tarSigShortcut + "gt" + sScore + weightPresences.at(iWeightPresence));
         } // bdtSignalLowerValues
       } // pTRanges
     } // weightPresences
   } // promptnesses
 
+  for(size_t iScore=0, nScores=bdtScores.size(); iScore<nScores; ++iScore) {
+    sinksScore.at(iScore).Flush();
+    filesOutScore.at(iScore)->Close();
+  }
+
   TLegend leg(0.7, 0.7, 0.9, 0.9);
   size_t iPromptness = 0;
   for(const auto& promptness : promptnesses) {
@@ -162,6 +172,7 @@ void efficiency_bdtcutset(const std::string& fileName) {
       cc.Print(("grEff_vs_" + tarSigShortcut + "_" + PtRangeString(pTIntervals.at(iPt)) + ".pdf" + priBra).c_str());
     } // lifeTimeRanges
   } // pTRanges
+  sink.Flush();
   fileOut->Close();
   fileIn->Close();
 }
@@ -4,6 +4,8 @@
 
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
+#include "OutputSink.hpp"
+#include "THnSparseProjector.hpp"
 
 #include <TAxis.h>
 #include <THnSparse.h>
@@ -36,6 +38,7 @@ const std::string bdtScanDir = "gt";
 // const std::string bdtScanDir = "lt";
 
 constexpr int Verobsity{0};
+bool gIsUseScanSuffixSums{true}; // project once to mass x scan score and read the thresholds out of suffix sums
 
 std::string GetPtCutName(size_t iPt);
 
@@ -46,7 +49,7 @@ enum : int {
   NModeRuns
 };
 
-void MassBdtQaThn(const std::string& fileNameIn, int modeRun) {
+void MassBdtQaThn(const std::string& fileNameIn, int modeRun, int nThreads) {
 //  LoadMacro("styles/mc_qa2.style.cc");
   const std::string fileName = ReadNthLine(fileNameIn);
 
@@ -88,44 +91,72 @@ void MassBdtQaThn(const std::string& fileNameIn, int modeRun) {
     tCutNames.emplace_back("T_" + to_string_with_precision(lifetimeRanges.at(iT), 2) + "_" + to_string_with_precision(lifetimeRanges.at(iT+1), 2));
   }
 
-  for(size_t iPt=0, nPts=pTRanges.size()-1; iPt<nPts && modeRun != MergeOnly; ++iPt) {
-    if(Verobsity >=1) std::cout << "\nProcessing iPt = " << iPt << "\n";
-    SetTHnSparseAxisRanges(histoIn, axesIndices.at(pTAxisTitle), pTRanges.at(iPt), pTRanges.at(iPt + 1));
-    SetTHnSparseAxisRanges(histoIn, axesIndices.at(bgAxisTitle), 0., bdtBgUpperValuesVsPt.at(iPt));
+  if(modeRun != MergeOnly) {
+    // all the projections are built in a single pass over histoIn filled bins
+    // slice dimensions are pT (together with the pT-dependent bkg score cut), lifetime and bdt (NP upper value x scan value)
+    THnSparseProjector projector(histoIn, axesIndices.at(massAxisTitle));
+    projector.SetScanAxis(axesIndices.at(bdtScanAxisTitle));
+    projector.SetUseScanSuffixSums(gIsUseScanSuffixSums);
+    projector.SetNThreads(nThreads);
+    std::vector<THnSparseProjector::Selection> pTSelections, tSelections, bdtSelections;
+    for(size_t iPt=0, nPts=pTRanges.size()-1; iPt<nPts; ++iPt) {
+      THnSparseProjector::Selection pTSelection{{axesIndices.at(pTAxisTitle), static_cast<float>(pTRanges.at(iPt)), static_cast<float>(pTRanges.at(iPt + 1))}};
+      // if the scan goes over the bkg score, its range overrides the pT-dependent one
+      if(bdtScanAxisTitle != bgAxisTitle) pTSelection.push_back({axesIndices.at(bgAxisTitle), 0.f, static_cast<float>(bdtBgUpperValuesVsPt.at(iPt))});
+      pTSelections.emplace_back(pTSelection);
+    }
     for(size_t iT=0, nTs=lifetimeRanges.size()-1; iT<nTs; ++iT) {
-      if(Verobsity >= 2) std::cout << "Processing iT = " << iT << "\n";
-      SetTHnSparseAxisRanges(histoIn, axesIndices.at(lifetimeAxisTitle), lifetimeRanges.at(iT), lifetimeRanges.at(iT + 1));
-      for(const auto& bdtNpUpper : bdtNPUpperValues) {
-        if(Verobsity >= 2) std::cout << "Processing bdtNpUpper = " << bdtNpUpper << "\n";
-        if(Verobsity >= 3) std::cout << "Processing bdtScan = ";
-        const std::string dirName = pTCutNames.at(iPt) + "/" + tCutNames.at(iT) + "/NPlt" + to_string_with_precision(bdtNpUpper, 2);
-        for (const auto& bdtScan: bdtScanValues) {
-          if(Verobsity >= 3) std::cout << bdtScan << " ";
-          if(bdtScanAxisTitle == bgAxisTitle && bdtScan > bdtBgUpperValuesVsPt.at(iPt)+0.001) continue;
-          if(bdtScanAxisTitle == npAxisTitle && bdtScan >= bdtNpUpper) continue;
-          const auto [bdtFrom, bdtTo] = bdtScanDir == "gt" ? std::make_pair(bdtScan, bdtNpUpper) : std::make_pair(0., bdtScan);
-          SetTHnSparseAxisRanges(histoIn, axesIndices.at(bdtScanAxisTitle), bdtFrom, bdtTo);
-          TH1D* histoMass = histoIn->Projection(axesIndices.at(massAxisTitle));
-          histoMass->SetDirectory(nullptr);
-          const std::string histoName = "hM_" + bdtScanShortCut + bdtScanDir + to_string_with_precision(bdtScan, 2);
-          CD(fileOut, dirName);
-          histoMass->Write(histoName.c_str());
-          SetTHnSparseAxisRanges(histoIn, axesIndices.at(bdtScanAxisTitle));
-        } // bdtScanValues
-        if(Verobsity >= 3) std::cout << "\n";
-      } // bdtNPUpperValues
-      SetTHnSparseAxisRanges(histoIn, axesIndices.at(lifetimeAxisTitle));
-      if(Verobsity >= 2) std::cout << "\n";
-    } // lifetimeRanges
-    SetTHnSparseAxisRanges(histoIn, axesIndices.at(pTAxisTitle));
-    SetTHnSparseAxisRanges(histoIn, axesIndices.at(bgAxisTitle));
-  } // pTRanges
+      tSelections.push_back({{axesIndices.at(lifetimeAxisTitle), static_cast<float>(lifetimeRanges.at(iT)), static_cast<float>(lifetimeRanges.at(iT + 1))}});
+    }
+    std::vector<std::vector<int>> bdtSelectionIndices(bdtNPUpperValues.size(), std::vector<int>(bdtScanValues.size(), -1));
+    for(size_t iNpUpper=0, nNpUppers=bdtNPUpperValues.size(); iNpUpper<nNpUppers; ++iNpUpper) {
+      const double bdtNpUpper = bdtNPUpperValues.at(iNpUpper);
+      for(size_t iScan=0, nScans=bdtScanValues.size(); iScan<nScans; ++iScan) {
+        const double bdtScan = bdtScanValues.at(iScan);
+        if(bdtScanAxisTitle == npAxisTitle && bdtScan >= bdtNpUpper) continue;
+        const auto [bdtFrom, bdtTo] = bdtScanDir == "gt" ? std::make_pair(bdtScan, bdtNpUpper) : std::make_pair(0., bdtScan);
+        bdtSelectionIndices.at(iNpUpper).at(iScan) = bdtSelections.size();
+        bdtSelections.push_back({{axesIndices.at(bdtScanAxisTitle), static_cast<float>(bdtFrom), static_cast<float>(bdtTo)}});
+      } // bdtScanValues
+    } // bdtNPUpperValues
+    projector.AddSliceDimension(pTSelections);
+    projector.AddSliceDimension(tSelections);
+    projector.AddSliceDimension(bdtSelections);
+    projector.Run();
+
+    OutputSink sink(fileOut);
+    for(size_t iPt=0, nPts=pTRanges.size()-1; iPt<nPts; ++iPt) {
+      if(Verobsity >=1) std::cout << "\nProcessing iPt = " << iPt << "\n";
+      for(size_t iT=0, nTs=lifetimeRanges.size()-1; iT<nTs; ++iT) {
+        if(Verobsity >= 2) std::cout << "Processing iT = " << iT << "\n";
+        for(size_t iNpUpper=0, nNpUppers=bdtNPUpperValues.size(); iNpUpper<nNpUppers; ++iNpUpper) {
+          const double bdtNpUpper = bdtNPUpperValues.at(iNpUpper);
+          if(Verobsity >= 2) std::cout << "Processing bdtNpUpper = " << bdtNpUpper << "\n";
+          if(Verobsity >= 3) std::cout << "Processing bdtScan = ";
+          const std::string dirName = pTCutNames.at(iPt) + "/" + tCutNames.at(iT) + "/NPlt" + to_string_with_precision(bdtNpUpper, 2);
+          for(size_t iScan=0, nScans=bdtScanValues.size(); iScan<nScans; ++iScan) {
+            const double bdtScan = bdtScanValues.at(iScan);
+            if(Verobsity >= 3) std::cout << bdtScan << " ";
+            if(bdtScanAxisTitle == bgAxisTitle && bdtScan > bdtBgUpperValuesVsPt.at(iPt)+0.001) continue;
+            if(bdtSelectionIndices.at(iNpUpper).at(iScan) < 0) continue;
+            TH1D* histoMass = projector.GetProjection({iPt, iT, static_cast<size_t>(bdtSelectionIndices.at(iNpUpper).at(iScan))});
+            const std::string histoName = "hM_" + bdtScanShortCut + bdtScanDir + to_string_with_precision(bdtScan, 2);
+            sink.Add(dirName, histoMass, histoName);
+          } // bdtScanValues
+          if(Verobsity >= 3) std::cout << "\n";
+        } // bdtNPUpperValues
+        if(Verobsity >= 2) std::cout << "\n";
+      } // lifetimeRanges
+    } // pTRanges
+    sink.Flush(); // the merging below reads these histograms back from fileOut
+  } // modeRun != MergeOnly
 
   if(modeRun != RunOnly) {
     const int nLowerPtBinsToExclude{2};
     pTCutNames.erase(pTCutNames.begin(), pTCutNames.begin()+nLowerPtBinsToExclude);
     pTRanges.erase(pTRanges.begin(), pTRanges.begin()+nLowerPtBinsToExclude);
 
+    OutputSink sink(fileOut);
     for (const auto& tcn : tCutNames) {
       for (const auto& bnpuv : bdtNPUpperValues) {
         for (const auto& bslv : bdtScanValues) {
@@ -136,11 +167,11 @@ void MassBdtQaThn(const std::string& fileNameIn, int modeRun) {
             histoNames.emplace_back(ptcn + "/" + tcn + "/NPlt" + to_string_with_precision(bnpuv, 2) + "/hM_" + bdtScanShortCut + bdtScanDir + to_string_with_precision(bslv, 2));
           }
           TH1* histoMerged = HelperMath::MergeHistograms(fileOut, histoNames);
-          HelperGeneral::CD(fileOut, GetPtCutName(pTRanges.size()-1) + "/" + tcn + "/NPlt" + to_string_with_precision(bnpuv, 2));
-          histoMerged->Write(("hM_" + bdtScanShortCut + bdtScanDir + to_string_with_precision(bslv, 2)).c_str());
+          sink.Add(GetPtCutName(pTRanges.size()-1) + "/" + tcn + "/NPlt" + to_string_with_precision(bnpuv, 2), histoMerged, "hM_" + bdtScanShortCut + bdtScanDir + to_string_with_precision(bslv, 2));
         } // bdtScanValues
       } // bdtNPUpperValues
     } // TCuts
+    sink.Flush();
   } // modeRun != RunOnly
 
   fileOut->Close();
@@ -153,9 +184,11 @@ std::string GetPtCutName(size_t iPt) {
 }
 
 int main(int argc, char* argv[]) {
+  const int nThreads = ExtractIntOption(argc, argv, "--threads", 1);
+  gIsUseScanSuffixSums = ExtractIntOption(argc, argv, "--scan-suffix-sums", 1) != 0;
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./mass_bdt_qa_thn fileNameIn (modeRun=RunOnly=0 [RunAndMerge=1, MergeOnly=2])" << std::endl;
+    std::cout << " ./mass_bdt_qa_thn fileNameIn (modeRun=RunOnly=0 [RunAndMerge=1, MergeOnly=2]) (--threads nThreads=1) (--scan-suffix-sums isUseScanSuffixSums=1)" << std::endl;
     exit(EXIT_FAILURE);
   }
 
@@ -163,7 +196,7 @@ int main(int argc, char* argv[]) {
   const int modeRun = argc > 2 ? std::stoi(argv[2]) : RunOnly;
   if(modeRun < 0 || modeRun >= NModeRuns) throw std::runtime_error("modeRun < 0 || modeRun >= NModeRuns");
 
-  MassBdtQaThn(fileNameIn, modeRun);
+  MassBdtQaThn(fileNameIn, modeRun, nThreads);
 
   return 0;
 }
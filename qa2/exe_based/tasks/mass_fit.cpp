@@ -12,6 +12,7 @@
 #include <TROOT.h>
 
 #include <iostream>
+#include <memory>
 
 using namespace HelperGeneral;
 using namespace HelperMath;
@@ -19,7 +20,7 @@ using namespace HelperPlot;
 
 std::vector<double> EvaluateLifetimeBinRanges(const std::vector<std::pair<std::string, std::string>>& sliceCuts, bool doPrint=false);
 
-void mass_fit(const std::string& fileName, bool isMC, bool isSaveToRoot) {
+void mass_fit(const std::string& fileName, bool isMC, bool isSaveToRoot, const std::string& fitCacheDir, bool isNativeFitter, bool isSimultaneous, bool isAnalyticGradient, bool isLinearSideBand, bool isMomentEstimate) {
   TString currentMacroPath = __FILE__;
   TString directory = currentMacroPath(0, currentMacroPath.Last('/'));
   gROOT->Macro( directory + "/../styles/mc_qa2.style.cc" );
@@ -33,7 +34,7 @@ void mass_fit(const std::string& fileName, bool isMC, bool isSaveToRoot) {
 
   const int bgShape = 2;
 
-  const bool drawRefit{false};
+  const bool drawRefit{isSimultaneous}; // the simultaneous fit result is the re-fit
 //  const bool drawRefit{true};
 
 //  const std::string mainDataType = isMC ? "all" : "data";
@@ -72,18 +73,18 @@ void mass_fit(const std::string& fileName, bool isMC, bool isSaveToRoot) {
     TH1D* histoYieldSignal = new TH1D(("histoYieldSignal_" + wu.name_).c_str(), "", ctBinEdges.size()-1, ctBinEdges.data());
     histoYieldSignal->GetXaxis()->SetTitle("T (ps)");
     histoYieldSignal->GetYaxis()->SetTitle("Entries");
-    int iSc{1};
+    std::vector<std::unique_ptr<ShapeFitter>> shapeFitters;
+    std::vector<TH1D*> histosMcSig, histosMcBg;
     for(auto& sc : sliceCuts) {
       const std::string histoName = mainDataType + "/Candidates_" + mainDataType + "_T_" + sc.first + "_" + sc.second + wu.dir_name_suffix_ + "/Mass" + wu.histo_name_suffix_ + "_" + mainDataType + "_T_" + sc.first + "_" + sc.second;
       const std::string histoMcSigName = mcSigDataType + "/Candidates_" + mcSigDataType + "_T_" + sc.first + "_" + sc.second + wu.dir_name_suffix_ + "/Mass" + wu.histo_name_suffix_ + "_" + mcSigDataType + "_T_" + sc.first + "_" + sc.second;
       const std::string histoMcBgName = mcBgDataType + "/Candidates_" + mcBgDataType + "_T_" + sc.first + "_" + sc.second + wu.dir_name_suffix_ + "/Mass" + wu.histo_name_suffix_ + "_" + mcBgDataType + "_T_" + sc.first + "_" + sc.second;
-      const std::string cutRangeText = sc.first + " < T < " + sc.second + " (ps)";
       TH1D* histoIn = GetObjectWithNullptrCheck<TH1D>(fileIn, histoName);
       histoIn->UseCurrentStyle();
       histoIn->Sumw2();
       if(rebinFactor != 1) histoIn->Rebin(rebinFactor);
       histoIn->SetLineColor(kBlue);
-      TH1D *histoMcSig, *histoMcBg;
+      TH1D *histoMcSig{nullptr}, *histoMcBg{nullptr};
       if(isMC) {
         histoMcSig = GetObjectWithNullptrCheck<TH1D>(fileIn, histoMcSigName);
         histoMcBg = GetObjectWithNullptrCheck<TH1D>(fileIn, histoMcBgName);
@@ -94,14 +95,38 @@ void mass_fit(const std::string& fileName, bool isMC, bool isSaveToRoot) {
           h->SetLineColor(kBlue);
         } // {histoMcSig, histoMcBg}
       } // isMC
+      histosMcSig.emplace_back(histoMcSig);
+      histosMcBg.emplace_back(histoMcBg);
+
+      auto& shapeFitter = shapeFitters.emplace_back(std::make_unique<ShapeFitter>(histoIn));
+      shapeFitter->SetExpectedMu(massLambdaC);
+      shapeFitter->SetExpectedSigma(massLambdaCDetectorWidth);
+      shapeFitter->SetSideBands(2.12, 2.20, 2.38, 2.42);
+      shapeFitter->SetPeakShape(peakShape);
+      shapeFitter->SetBgPolN(bgShape);
+      shapeFitter->SetUseAnalyticGradient(isAnalyticGradient);
+      shapeFitter->SetUseLinearSideBandFit(isLinearSideBand);
+      shapeFitter->SetUseMomentEstimate(isMomentEstimate);
+      shapeFitter->SetFitCacheDirectory(fitCacheDir);
+      shapeFitter->SetUseNativeFitter(isNativeFitter);
+    } // sliceCuts
+
+    // the re-fit is the simultaneous one over all the lifetime bins with the common peak shape
+    if(isSimultaneous) {
+      std::vector<ShapeFitter*> fitters;
+      for(const auto& sf : shapeFitters) fitters.emplace_back(sf.get());
+      ShapeFitter::FitSimultaneous(fitters);
+    } else {
+      for(const auto& sf : shapeFitters) sf->Fit();
+    }
+    if(!shapeFitters.empty()) histoYieldSignal->SetTitle(("S from the " + shapeFitters.front()->GetYieldSource()).c_str());
 
-      ShapeFitter shapeFitter(histoIn);
-      shapeFitter.SetExpectedMu(massLambdaC);
-      shapeFitter.SetExpectedSigma(massLambdaCDetectorWidth);
-      shapeFitter.SetSideBands(2.12, 2.20, 2.38, 2.42);
-      shapeFitter.SetPeakShape(peakShape);
-      shapeFitter.SetBgPolN(bgShape);
-      shapeFitter.Fit();
+    int iSc{1};
+    for(auto& sc : sliceCuts) {
+      const std::string cutRangeText = sc.first + " < T < " + sc.second + " (ps)";
+      ShapeFitter& shapeFitter = *shapeFitters.at(iSc-1);
+      TH1D* histoMcSig = histosMcSig.at(iSc-1);
+      TH1D* histoMcBg = histosMcBg.at(iSc-1);
 
       histoYieldSignal->SetBinContent(iSc, shapeFitter.GetSignalIntegral3Sigma());
       histoYieldSignal->SetBinError(iSc, shapeFitter.GetSignalErrIntegral3Sigma());
@@ -215,9 +240,15 @@ std::vector<double> EvaluateLifetimeBinRanges(const std::vector<std::pair<std::s
 }
 
 int main(int argc, char* argv[]) {
+  const std::string fitCacheDir = ExtractStringOption(argc, argv, "--fit-cache", "");
+  const bool isNativeFitter = ExtractIntOption(argc, argv, "--native-fitter", 0) != 0;
+  const bool isSimultaneous = ExtractIntOption(argc, argv, "--simultaneous", 0) != 0;
+  const bool isAnalyticGradient = ExtractIntOption(argc, argv, "--analytic-gradient", 0) != 0;
+  const bool isLinearSideBand = ExtractIntOption(argc, argv, "--linear-sideband", 0) != 0;
+  const bool isMomentEstimate = ExtractIntOption(argc, argv, "--moment-estimate", 0) != 0;
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./mass_fit fileName (isMc=true isSaveRoot=false)" << std::endl;
+    std::cout << " ./mass_fit fileName (isMc=true isSaveRoot=false) (--fit-cache fitCacheDir --native-fitter 0|1 --simultaneous 0|1 --analytic-gradient 0|1 --linear-sideband 0|1 --moment-estimate 0|1)" << std::endl;
     exit(EXIT_FAILURE);
   }
 
@@ -225,7 +256,7 @@ int main(int argc, char* argv[]) {
   const bool isMc = argc > 2 ? string_to_bool(argv[2]) : true;
   const bool isSaveToRoot = argc > 3 ? string_to_bool(argv[3]) : false;
 
-  mass_fit(fileName, isMc, isSaveToRoot);
+  mass_fit(fileName, isMc, isSaveToRoot, fitCacheDir, isNativeFitter, isSimultaneous, isAnalyticGradient, isLinearSideBand, isMomentEstimate);
 
   return 0;
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #include <TLegend.h>
 
 #include <iostream>
+#include <memory>
 
 using namespace HelperGeneral;
 using namespace HelperMath;
@@ -22,28 +23,47 @@ const int rebinFactor{4};
 const std::string peakShape{"DSCB"};
 const int bgShape{2};
 
-void mass_fit2(const std::string& fileName, const bool isSaveToRoot) {
+void mass_fit2(const std::string& fileName, const bool isSaveToRoot, const std::string& fitCacheDir, bool isNativeFitter, bool isSimultaneous, bool isAnalyticGradient, bool isLinearSideBand, bool isMomentEstimate) {
   const std::string fitShape = peakShape + "pol" + std::to_string(bgShape);
   LoadMacro("styles/mc_qa2.style.cc");
   TFile* fileIn = OpenFileWithNullptrCheck(fileName);
 
-  for(size_t iT=0, nTs=lifetimeRanges.size()-1; iT<nTs; ++iT) {
-    const std::string priBra = EvaluatePrintingBracket(nTs, iT);
+  const size_t nTs = lifetimeRanges.size()-1;
+  std::vector<std::unique_ptr<ShapeFitter>> shapeFitters;
+  for(size_t iT=0; iT<nTs; ++iT) {
     const std::string histoInName = "data/pT_0_20/T_" + to_string_with_precision(lifetimeRanges.at(iT), 2) + "_" +  to_string_with_precision(lifetimeRanges.at(iT+1), 2) + "/hM_NPgt0.01";
-    const std::string cutRangeText = to_string_with_precision(lifetimeRanges.at(iT), 2) + " < T < " + to_string_with_precision(lifetimeRanges.at(iT+1), 2) + " (ps)";
     TH1* histoIn = GetObjectWithNullptrCheck<TH1>(fileIn, histoInName);
     histoIn->UseCurrentStyle();
     histoIn->SetMarkerSize(0);
     histoIn->SetLineColor(kBlue);
     if(rebinFactor != 1) histoIn->Rebin(rebinFactor);
 
-    ShapeFitter shapeFitter(histoIn);
-    shapeFitter.SetExpectedMu(massLambdaC);
-    shapeFitter.SetExpectedSigma(massLambdaCDetectorWidth);
-    shapeFitter.SetSideBands(2.12, 2.23, 2.34, 2.42);
-    shapeFitter.SetPeakShape(peakShape);
-    shapeFitter.SetBgPolN(bgShape);
-    shapeFitter.Fit();
+    auto& shapeFitter = shapeFitters.emplace_back(std::make_unique<ShapeFitter>(histoIn));
+    shapeFitter->SetExpectedMu(massLambdaC);
+    shapeFitter->SetExpectedSigma(massLambdaCDetectorWidth);
+    shapeFitter->SetSideBands(2.12, 2.23, 2.34, 2.42);
+    shapeFitter->SetPeakShape(peakShape);
+    shapeFitter->SetBgPolN(bgShape);
+    shapeFitter->SetUseAnalyticGradient(isAnalyticGradient);
+    shapeFitter->SetUseLinearSideBandFit(isLinearSideBand);
+    shapeFitter->SetUseMomentEstimate(isMomentEstimate);
+    shapeFitter->SetFitCacheDirectory(fitCacheDir);
+    shapeFitter->SetUseNativeFitter(isNativeFitter);
+  } // nTs
+
+  // the re-fit is the simultaneous one over all the lifetime bins with the common peak shape
+  if(isSimultaneous) {
+    std::vector<ShapeFitter*> fitters;
+    for(const auto& sf : shapeFitters) fitters.emplace_back(sf.get());
+    ShapeFitter::FitSimultaneous(fitters);
+  } else {
+    for(const auto& sf : shapeFitters) sf->Fit();
+  }
+
+  for(size_t iT=0; iT<nTs; ++iT) {
+    const std::string priBra = EvaluatePrintingBracket(nTs, iT);
+    const std::string cutRangeText = to_string_with_precision(lifetimeRanges.at(iT), 2) + " < T < " + to_string_with_precision(lifetimeRanges.at(iT+1), 2) + " (ps)";
+    ShapeFitter& shapeFitter = *shapeFitters.at(iT);
 
     for(const auto& lines : {shapeFitter.GetAllFunc(), shapeFitter.GetAllReFunc(), shapeFitter.GetSideBandFunc(), shapeFitter.GetSideBandReFunc()}) lines->SetLineWidth(3);
     for(const auto& alls : {shapeFitter.GetAllFunc(), shapeFitter.GetAllReFunc()}) alls->SetLineColor(kRed);
@@ -121,16 +141,22 @@ void mass_fit2(const std::string& fileName, const bool isSaveToRoot) {
 }
 
 int main(int argc, char* argv[]) {
+  const std::string fitCacheDir = ExtractStringOption(argc, argv, "--fit-cache", "");
+  const bool isNativeFitter = ExtractIntOption(argc, argv, "--native-fitter", 0) != 0;
+  const bool isSimultaneous = ExtractIntOption(argc, argv, "--simultaneous", 0) != 0;
+  const bool isAnalyticGradient = ExtractIntOption(argc, argv, "--analytic-gradient", 0) != 0;
+  const bool isLinearSideBand = ExtractIntOption(argc, argv, "--linear-sideband", 0) != 0;
+  const bool isMomentEstimate = ExtractIntOption(argc, argv, "--moment-estimate", 0) != 0;
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./mass_fit fileName (isSaveRoot=false)" << std::endl;
+    std::cout << " ./mass_fit2 fileName (isSaveRoot=false) (--fit-cache fitCacheDir --native-fitter 0|1 --simultaneous 0|1 --analytic-gradient 0|1 --linear-sideband 0|1 --moment-estimate 0|1)" << std::endl;
     exit(EXIT_FAILURE);
   }
 
   const std::string fileName = argv[1];
   const bool isSaveToRoot = argc > 2 ? string_to_bool(argv[2]) : false;
 
-  mass_fit2(fileName, isSaveToRoot);
+  mass_fit2(fileName, isSaveToRoot, fitCacheDir, isNativeFitter, isSimultaneous, isAnalyticGradient, isLinearSideBand, isMomentEstimate);
 
   return 0;
 }
\ No newline at end of file
@@ -4,23 +4,31 @@
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
 #include "HelperPlot.hpp"
+#include "RawYieldStore.hpp"
 
 #include <TFile.h>
 #include <TGraphErrors.h>
 #include <TH1.h>
+#include <TROOT.h>
 
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <memory>
 #include <numeric>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 using namespace HelperGeneral;
 using namespace HelperMath;
 using namespace HelperPlot;
 
-void MultiFitQa(const bool isVerbose=true) {
+void MultiFitQa(const bool isVerbose=true, const std::string& storeFileName="", int nThreads=1, int nScoresPerBatch=10) {
   LoadMacro("styles/mc_qa2.style.cc");
   const std::string histoName = "hRawYieldsSignal";
   const std::string fileNameTemplate = "RawYields_Lc/RawYields_Lc";
+  const std::string runNameTemplate = "RawYields_Lc"; // run name in the RawYieldStore
   const int nTrials = 100;
   std::vector<double> bdtScores;
   for(int i=1; i<=99; i++) {
@@ -45,99 +53,113 @@ void MultiFitQa(const bool isVerbose=true) {
   const size_t nVars = variables.size();
   const size_t nBdtScores = bdtScores.size();
 
+  // the results of all the trials are read either from the RawYieldStore(s) (e.g. "trials/*/RawYields_Lc.NP.store.root"),
+  // or from the file of each trial and BDT score
+  std::unique_ptr<RawYieldStore> store = storeFileName.empty() ? nullptr : std::make_unique<RawYieldStore>(storeFileName);
+  auto RunName = [&](size_t iScore) {
+    return runNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(iScore), 2);
+  };
+
   TFile* fileMarkUp{nullptr};
-  int iTrial{0};
-  do {
-    fileMarkUp = TFile::Open(("trials/" + std::to_string(trialNumbers.at(iTrial)) + "/" + fileNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(0), 2) + ".root").c_str());
-    ++iTrial;
+  int trialMarkUp{-1};
+  if(store == nullptr) {
+    int iTrial{0};
+    do {
+      fileMarkUp = TFile::Open(("trials/" + std::to_string(trialNumbers.at(iTrial)) + "/" + fileNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(0), 2) + ".root").c_str());
+      ++iTrial;
+    }
+    while(fileMarkUp == nullptr);
+  } else {
+    for(const auto& trial : trialNumbers) {
+      if(store->Has(RunName(0), variables.at(0), trial)) {
+        trialMarkUp = trial;
+        break;
+      }
+    }
+    if(trialMarkUp < 0) throw std::runtime_error("MultiFitQa(): no trial of " + RunName(0) + " in " + storeFileName);
   }
-  while(fileMarkUp == nullptr);
+  auto GetMarkUpHisto = [&](const std::string& variable) {
+    return store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileMarkUp, variable) : store->GetHisto(RunName(0), variable, trialMarkUp);
+  };
 
-  TH1* histoMarkUp = GetObjectWithNullptrCheck<TH1>(fileMarkUp, variables.at(0));
+  TH1* histoMarkUp = GetMarkUpHisto(variables.at(0));
   const size_t nLifetimeRanges = histoMarkUp->GetNbinsX();
 
-  tensor<TGraphErrors*, 3> graph = make_tensor<TGraphErrors*, 3>({nVars, nLifetimeRanges, nBdtScores}, nullptr);
-  tensor<std::map<double, size_t>, 3> values = make_tensor<std::map<double, size_t>, 3>({nVars, nLifetimeRanges, nBdtScores}, {});
-  tensor<std::map<double, size_t>, 3> errors = make_tensor<std::map<double, size_t>, 3>({nVars, nLifetimeRanges, nBdtScores}, {});
-  tensor<TGraphErrors*, 3> graphVsChi2 = make_tensor<TGraphErrors*, 3>({nVars, nLifetimeRanges, nBdtScores}, nullptr);
-  for(size_t iVar=0; iVar<nVars; ++iVar) {
-    for (size_t iT = 0; iT < nLifetimeRanges; ++iT) {
-      for (size_t iScore = 0; iScore < nBdtScores; ++iScore) {
-        auto& gr = graph.at(iVar).at(iT).at(iScore);
-        gr = new TGraphErrors();
-        const std::string grName = variables.at(iVar) + "_T" + std::to_string(iT) + "_NPgt" + to_string_with_precision(bdtScores.at(iScore), 2);
-        gr->SetName(grName.c_str());
-        gr->SetTitle(grName.c_str());
-        gr->GetXaxis()->SetTitle("Trial #");
-        gr->GetYaxis()->SetTitle(histoName.c_str());
+  // the BDT scores are processed in batches of nScoresPerBatch, so that the memory stays bounded by the batch:
+  // the results of all the trials for the batch's scores are loaded into flat arrays, [iTrial][iScore in batch][iVar][iT]
+  // (the chi2 without iVar), reused by the next batch; the trials are shared between the threads, each of which opens,
+  // reads and closes one file at a time, and the graphs are built from the arrays in the trial order only when they are drawn
+  const size_t nTrialNumbers = trialNumbers.size();
+  const size_t nScoresInBatch = std::min(static_cast<size_t>(nScoresPerBatch), nBdtScores);
+  auto IndexScore = [&](size_t iTrial, size_t iScore) {
+    return iTrial*nScoresInBatch + iScore % nScoresInBatch; // the batches start at multiples of nScoresInBatch
+  };
+  auto Index = [&](size_t iTrial, size_t iScore, size_t iVar, size_t iT) {
+    return (IndexScore(iTrial, iScore)*nVars + iVar)*nLifetimeRanges + iT;
+  };
+  auto IndexChi2 = [&](size_t iTrial, size_t iScore, size_t iT) {
+    return IndexScore(iTrial, iScore)*nLifetimeRanges + iT;
+  };
+  std::vector<double> values(nTrialNumbers*nScoresInBatch*nVars*nLifetimeRanges);
+  std::vector<double> errors(values.size());
+  std::vector<double> chi2s(nTrialNumbers*nScoresInBatch*nLifetimeRanges);
+  std::vector<char> isPresent(nTrialNumbers*nScoresInBatch, false); // char, not bool, so that the threads write into distinct bytes
 
-        auto& grVsChi2 = graphVsChi2.at(iVar).at(iT).at(iScore);
-        grVsChi2 = new TGraphErrors();
-        const std::string grVsChi2Name = variables.at(iVar) + "VsChi2" + "_T" + std::to_string(iT) + "_NPgt" + to_string_with_precision(bdtScores.at(iScore), 2);
-        grVsChi2->SetName(grVsChi2Name.c_str());
-        grVsChi2->SetTitle(grVsChi2Name.c_str());
-        grVsChi2->GetXaxis()->SetTitle("hRawYieldsChiSquareTotal");
-        grVsChi2->GetYaxis()->SetTitle(histoName.c_str());
-      } // nBdtScores
-    } // nLifetimeRanges
-  } // nVars
-
-  for(const auto& trial : trialNumbers) {
-    for(size_t iScore=0; iScore<nBdtScores; ++iScore) {
+  auto ReadTrial = [&](size_t iTrial, size_t iScoreBegin, size_t iScoreEnd) {
+    const int trial = trialNumbers.at(iTrial);
+    for(size_t iScore=iScoreBegin; iScore<iScoreEnd; ++iScore) {
+      if(store != nullptr) {
+        const std::string runName = RunName(iScore);
+        if(!store->Has(runName, "hRawYieldsChiSquareTotal", trial)) {
+          if(isVerbose) std::cout << (runName + " of trial " + std::to_string(trial) + " is missing\n");
+          continue;
+        }
+        for(size_t iVar=0; iVar<nVars; ++iVar) {
+          for(size_t iT=0; iT<nLifetimeRanges; ++iT) {
+            std::tie(values.at(Index(iTrial, iScore, iVar, iT)), errors.at(Index(iTrial, iScore, iVar, iT))) = store->Get(runName, variables.at(iVar), iT, trial);
+          } // nLifetimeRanges
+        } // nVars
+        for(size_t iT=0; iT<nLifetimeRanges; ++iT) {
+          chi2s.at(IndexChi2(iTrial, iScore, iT)) = store->Get(runName, "hRawYieldsChiSquareTotal", iT, trial).first;
+        } // nLifetimeRanges
+        isPresent.at(IndexScore(iTrial, iScore)) = true;
+        continue;
+      }
       const std::string fileName = "trials/" + std::to_string(trial) + "/" + fileNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(iScore), 2) + ".root";
-      if(isVerbose) std::cout << "Opening " << fileName;
-      TFile* fileIn = TFile::Open(fileName.c_str(), "read");
-      if(isVerbose) std::cout << ", opened successfully\n";
+      std::unique_ptr<TFile> fileIn{TFile::Open(fileName.c_str(), "read")};
       if(fileIn == nullptr) {
-        if(isVerbose) std::cout << ", " << fileName << " is missing\n";
+        if(isVerbose) std::cout << (fileName + " is missing\n");
         continue;
       }
+      TH1* histoChi2 = GetObjectWithNullptrCheck<TH1>(fileIn.get(), "hRawYieldsChiSquareTotal");
       for(size_t iVar=0; iVar<nVars; ++iVar) {
-        if(isVerbose) std::cout << "Reading histogram" << variables.at(iVar);
-        TH1* histoIn = GetObjectWithNullptrCheck<TH1>(fileIn, variables.at(iVar));
-        TH1* histoChi2 = GetObjectWithNullptrCheck<TH1>(fileIn, "hRawYieldsChiSquareTotal");
-        if(isVerbose) std::cout << ", read successfully\t";
-        if(isVerbose) std::cout << "iBin = ";
-        for (int iBin = 1; iBin <= static_cast<int>(nLifetimeRanges); ++iBin) {
-          if(isVerbose) std::cout << iBin << " ";
-          const double value = histoIn->GetBinContent(iBin);
-          const double error = histoIn->GetBinError(iBin);
-          auto gr = graph.at(iVar).at(iBin - 1).at(iScore);
-          gr->AddPoint(trial, value);
-          gr->SetPointError(gr->GetN() - 1, 0, error);
-          values.at(iVar).at(iBin - 1).at(iScore).insert({value, trial});
-          errors.at(iVar).at(iBin - 1).at(iScore).insert({error, trial});
-
-          const double chi2 = histoChi2->GetBinContent(iBin);
-          auto grVsChi2 = graphVsChi2.at(iVar).at(iBin - 1).at(iScore);
-          grVsChi2->AddPoint(chi2, value);
-          grVsChi2->SetPointError(grVsChi2->GetN() - 1, 0, error);
+        TH1* histoIn = GetObjectWithNullptrCheck<TH1>(fileIn.get(), variables.at(iVar));
+        for(size_t iT=0; iT<nLifetimeRanges; ++iT) {
+          values.at(Index(iTrial, iScore, iVar, iT)) = histoIn->GetBinContent(iT + 1);
+          errors.at(Index(iTrial, iScore, iVar, iT)) = histoIn->GetBinError(iT + 1);
         } // nLifetimeRanges
-        if(isVerbose) std::cout << "\n";
       } // nVars
-      if(isVerbose) std::cout << "\nClosing " << fileName;
+      for(size_t iT=0; iT<nLifetimeRanges; ++iT) {
+        chi2s.at(IndexChi2(iTrial, iScore, iT)) = histoChi2->GetBinContent(iT + 1);
+      } // nLifetimeRanges
       fileIn->Close();
-      if(isVerbose) std::cout << ", closed successfully\n\n";
+      isPresent.at(IndexScore(iTrial, iScore)) = true;
+      if(isVerbose) std::cout << (fileName + " read successfully\n");
     } // nBdtScores
-  } // trialNumbers
-
-  auto FindMapMedian = [](const std::map<double, size_t>& map) {
-    const size_t mapSize = map.size();
-    auto it = map.begin();
-    std::advance(it, mapSize/2);
-    return it->second;
   };
 
-  auto FindGraphsPointByX = [](const TGraph* gr, double x) {
-    const int nPoints = gr->GetN();
-    for(int iPoint=0; iPoint<nPoints; ++ iPoint) {
-      const double grX = gr->GetPointX(iPoint);
-      if(std::fabs(grX - x) < 1e-4) return iPoint;
-    }
-    return -1;
+  auto EvaluateMedian = [](std::vector<double>& vec) {
+    if(vec.empty()) return 0.;
+    std::nth_element(vec.begin(), vec.begin() + vec.size()/2, vec.end());
+    return vec.at(vec.size()/2);
   };
 
-  for (size_t iScore = 0; iScore < nBdtScores; ++iScore) {
+  for(const auto& variable : variables) {
+    MkDirBash(variable);
+    MkDirBash(variable + "VsChi2");
+  }
+
+  auto WriteScore = [&](size_t iScore) {
     const std::string priBra = EvaluatePrintingBracket(nBdtScores, iScore);
     const std::string fileSmoothName = "smooth/" + fileNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(iScore), 2) + ".root";
     auto getDirectory = [](const std::string &s) -> std::string {
@@ -151,33 +173,52 @@ void MultiFitQa(const bool isVerbose=true) {
     if(!dirSmoothPath.empty()) MkDirBash(dirSmoothPath);
     TFile* fileSmooth = TFile::Open(("smooth/" + fileNameTemplate + ".NPgt" + to_string_with_precision(bdtScores.at(iScore), 2) + ".root").c_str(), "recreate");
     for(size_t iVar=0; iVar<nVars; ++iVar) {
-      TH1* histoSmooth = dynamic_cast<TH1*>(GetObjectWithNullptrCheck<TH1>(fileMarkUp, variables.at(iVar))->Clone());
+      TH1* histoSmooth = dynamic_cast<TH1*>(GetMarkUpHisto(variables.at(iVar))->Clone());
       histoSmooth->Reset();
       for (size_t iT = 0; iT < nLifetimeRanges; ++iT) {
+        const std::string grName = variables.at(iVar) + "_T" + std::to_string(iT) + "_NPgt" + to_string_with_precision(bdtScores.at(iScore), 2);
+        TGraphErrors gr;
+        gr.SetName(grName.c_str());
+        gr.SetTitle(grName.c_str());
+        gr.GetXaxis()->SetTitle("Trial #");
+        gr.GetYaxis()->SetTitle(histoName.c_str());
+        const std::string grVsChi2Name = variables.at(iVar) + "VsChi2" + "_T" + std::to_string(iT) + "_NPgt" + to_string_with_precision(bdtScores.at(iScore), 2);
+        TGraphErrors grVsChi2;
+        grVsChi2.SetName(grVsChi2Name.c_str());
+        grVsChi2.SetTitle(grVsChi2Name.c_str());
+        grVsChi2.GetXaxis()->SetTitle("hRawYieldsChiSquareTotal");
+        grVsChi2.GetYaxis()->SetTitle(histoName.c_str());
+        std::vector<double> trialValues, trialErrors;
+        for(size_t iTrial=0; iTrial<nTrialNumbers; ++iTrial) {
+          if(!isPresent.at(IndexScore(iTrial, iScore))) continue;
+          const double value = values.at(Index(iTrial, iScore, iVar, iT));
+          const double error = errors.at(Index(iTrial, iScore, iVar, iT));
+          gr.AddPoint(trialNumbers.at(iTrial), value);
+          gr.SetPointError(gr.GetN() - 1, 0, error);
+          grVsChi2.AddPoint(chi2s.at(IndexChi2(iTrial, iScore, iT)), value);
+          grVsChi2.SetPointError(grVsChi2.GetN() - 1, 0, error);
+          trialValues.emplace_back(value);
+          trialErrors.emplace_back(error);
+        } // nTrialNumbers
+        const double medianValue = EvaluateMedian(trialValues);
+        const double medianError = EvaluateMedian(trialErrors);
+
         TCanvas cc("cc", "");
         TCanvas ccVsChi2("ccVsChi2", "");
         cc.SetCanvasSize(1200, 800);
         ccVsChi2.SetCanvasSize(1200, 800);
-        const auto& gr = graph.at(iVar).at(iT).at(iScore);
-        const auto& grVsChi2 = graphVsChi2.at(iVar).at(iT).at(iScore);
         cc.cd();
-        gr->Draw("APE");
+        gr.Draw("APE");
         ccVsChi2.cd();
-        grVsChi2->Draw("APE");
-        const size_t medianValueTrial = FindMapMedian(values.at(iVar).at(iT).at(iScore));
-        const int medianValuePoint = FindGraphsPointByX(gr, static_cast<double>(medianValueTrial));
-        const double medianValue = gr->GetPointY(medianValuePoint);
-        const size_t medianErrorTrial = FindMapMedian(errors.at(iVar).at(iT).at(iScore));
-        const int medianErrorPoint = FindGraphsPointByX(gr, static_cast<double>(medianErrorTrial));
-        const double medianError = gr->GetErrorY(medianErrorPoint);
+        grVsChi2.Draw("APE");
         histoSmooth->SetBinContent(iT + 1, medianValue);
         histoSmooth->SetBinError(iT + 1, medianError);
-        TF1* lineValue = HorizontalLine4Graph(medianValue, gr);
-        TF1* lineErrorUp = HorizontalLine4Graph(medianValue + medianError, gr);
-        TF1* lineErrorDown = HorizontalLine4Graph(medianValue - medianError, gr);
-        TF1* lineValueChi2 = HorizontalLine4Graph(medianValue, grVsChi2);
-        TF1* lineErrorUpChi2 = HorizontalLine4Graph(medianValue + medianError, grVsChi2);
-        TF1* lineErrorDownChi2 = HorizontalLine4Graph(medianValue - medianError, grVsChi2);
+        TF1* lineValue = HorizontalLine4Graph(medianValue, &gr);
+        TF1* lineErrorUp = HorizontalLine4Graph(medianValue + medianError, &gr);
+        TF1* lineErrorDown = HorizontalLine4Graph(medianValue - medianError, &gr);
+        TF1* lineValueChi2 = HorizontalLine4Graph(medianValue, &grVsChi2);
+        TF1* lineErrorUpChi2 = HorizontalLine4Graph(medianValue + medianError, &grVsChi2);
+        TF1* lineErrorDownChi2 = HorizontalLine4Graph(medianValue - medianError, &grVsChi2);
         for (const auto& line: {lineErrorUp, lineErrorDown, lineErrorUpChi2, lineErrorDownChi2}) {
           line->SetLineStyle(7);
           line->SetLineStyle(7);
@@ -191,8 +232,6 @@ void MultiFitQa(const bool isVerbose=true) {
           line->Draw("same");
           ++iLine;
         }
-        MkDirBash(variables.at(iVar));
-        MkDirBash(variables.at(iVar) + "VsChi2");
         cc.Print((variables.at(iVar) + "/" + variables.at(iVar) + "_T_" + std::to_string(iT+1) + ".pdf" + priBra).c_str(), "pdf");
         ccVsChi2.Print((variables.at(iVar) + "VsChi2" + "/" + variables.at(iVar) + "VsChi2" + "_T_" + std::to_string(iT+1) + ".pdf" + priBra).c_str(), "pdf");
       } // nLifetimeRanges
@@ -200,13 +239,51 @@ void MultiFitQa(const bool isVerbose=true) {
       histoSmooth->Write();
     } // nVars
      fileSmooth->Close();
+  };
+
+  auto ReadBatch = [&](size_t iScoreBegin, size_t iScoreEnd) {
+    std::fill(isPresent.begin(), isPresent.end(), false);
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> threadExceptions(nThreads, nullptr);
+    threads.reserve(nThreads);
+    for(int iThread=0; iThread<nThreads; ++iThread) {
+      threads.emplace_back([&, iThread]() {
+        try {
+          for(size_t iTrial=iThread; iTrial<nTrialNumbers; iTrial+=nThreads) {
+            ReadTrial(iTrial, iScoreBegin, iScoreEnd);
+          }
+        } catch(...) {
+          threadExceptions.at(iThread) = std::current_exception();
+        }
+      });
+    }
+    for(auto& thread : threads) {
+      thread.join();
+    }
+    for(const auto& exception : threadExceptions) {
+      if(exception != nullptr) std::rethrow_exception(exception);
+    }
+  };
+
+  if(nThreads > 1) ROOT::EnableThreadSafety();
+  for(size_t iScoreBegin=0; iScoreBegin<nBdtScores; iScoreBegin+=nScoresInBatch) {
+    const size_t iScoreEnd = std::min(iScoreBegin + nScoresInBatch, nBdtScores);
+    ReadBatch(iScoreBegin, iScoreEnd);
+    for(size_t iScore=iScoreBegin; iScore<iScoreEnd; ++iScore) {
+      WriteScore(iScore);
+    }
   } // nBdtScores
-  fileMarkUp->Close();
+  if(fileMarkUp != nullptr) fileMarkUp->Close();
 }
 
 int main(int argc, char* argv[]) {
 
+  const std::string storeFileName = ExtractStringOption(argc, argv, "--store", "");
+  const int nThreads = ExtractIntOption(argc, argv, "--threads", 1);
+  if(nThreads < 1) throw std::runtime_error("main(): nThreads < 1");
+  const int nScoresPerBatch = ExtractIntOption(argc, argv, "--scores-per-batch", 10);
+  if(nScoresPerBatch < 1) throw std::runtime_error("main(): nScoresPerBatch < 1");
   const bool isVerbose = argc > 1 ? string_to_bool(argv[1]) : false;
 
-  MultiFitQa(isVerbose);
+  MultiFitQa(isVerbose, storeFileName, nThreads, nScoresPerBatch);
 }
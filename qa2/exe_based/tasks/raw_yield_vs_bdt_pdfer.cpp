@@ -4,12 +4,14 @@
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
 #include "HelperPlot.hpp"
+#include "RawYieldStore.hpp"
 
 #include <TFile.h>
 #include <TGraphErrors.h>
 #include <TStyle.h>
 
 #include <iostream>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -19,7 +21,7 @@ using namespace HelperPlot;
 
 std::pair<double, double> EvaluateMeanAndStdDevOfGraph(const TGraph* graph, double from=-1e9, double to=1e9);
 
-void raw_yield_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string& histoName) {
+void raw_yield_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::string& histoName, const std::string& storeFileName) {
   LoadMacro("styles/mc_qa2.style.cc");
   gStyle->SetMarkerSize(0.6);
   gStyle->SetNdivisions(315, "X");
@@ -35,13 +37,19 @@ void raw_yield_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::stri
   const double ratioSigmaTolerance = 2.;
   //=================================================================
 
-  TFile* fileMarkup = OpenFileWithNullptrCheck(fileNameTemplate + "." + targetSignals.at(0) + "gt" + to_string_with_precision(bdtScores.at(0), 2) + ".root");
-  TH1* histoMarkup = GetObjectWithNullptrCheck<TH1>(fileMarkup, histoName);
+  // the results are read either from the single RawYieldStore, or from the file of each run
+  std::unique_ptr<RawYieldStore> store = storeFileName.empty() ? nullptr : std::make_unique<RawYieldStore>(storeFileName);
+  auto RunName = [&](const std::string& targetSignal, double score) {
+    return fileNameTemplate + "." + targetSignal + "gt" + to_string_with_precision(score, 2);
+  };
+
+  TFile* fileMarkup = store == nullptr ? OpenFileWithNullptrCheck(RunName(targetSignals.at(0), bdtScores.at(0)) + ".root") : nullptr;
+  TH1* histoMarkup = store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileMarkup, histoName) : store->GetHisto(RunName(targetSignals.at(0), bdtScores.at(0)), histoName);
   std::vector<float> lifeTimeRanges;
   for(int iBin=1; iBin<=histoMarkup->GetNbinsX()+1; ++iBin) {
     lifeTimeRanges.emplace_back(histoMarkup->GetBinLowEdge(iBin));
   }
-  fileMarkup->Close();
+  if(fileMarkup != nullptr) fileMarkup->Close();
 
   enum Graph : short {
     kYield = 0,
@@ -77,9 +85,10 @@ void raw_yield_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::stri
 
   for(const auto& score : bdtScores) {
     for(int iTargetSignal=0; iTargetSignal<targetSignals.size(); ++iTargetSignal) {
-      TFile* fileIn = OpenFileWithNullptrCheck(fileNameTemplate + "." + targetSignals.at(iTargetSignal) + "gt" + to_string_with_precision(score, 2) + ".root");
-      TH1* histoYield = GetObjectWithNullptrCheck<TH1>(fileIn, histoName);
-      TH1* histoChi2 = GetObjectWithNullptrCheck<TH1>(fileIn, "hRawYieldsChiSquareTotal");
+      const std::string runName = RunName(targetSignals.at(iTargetSignal), score);
+      TFile* fileIn = store == nullptr ? OpenFileWithNullptrCheck(runName + ".root") : nullptr;
+      TH1* histoYield = store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileIn, histoName) : store->GetHisto(runName, histoName);
+      TH1* histoChi2 = store == nullptr ? GetObjectWithNullptrCheck<TH1>(fileIn, "hRawYieldsChiSquareTotal") : store->GetHisto(runName, "hRawYieldsChiSquareTotal");
       for(int iLifeTimeRange=0; iLifeTimeRange<lifeTimeRanges.size()-1; ++iLifeTimeRange) {
         auto gr = graph.at(kYield).at(iLifeTimeRange).at(iTargetSignal);
         gr->SetPoint(gr->GetN(), score, histoYield->GetBinContent(iLifeTimeRange + 1));
@@ -91,7 +100,7 @@ void raw_yield_vs_bdt_pdfer(const std::string& fileNameTemplate, const std::stri
         auto grc = graph.at(kChi2).at(iLifeTimeRange).at(iTargetSignal);
         grc->SetPoint(grc->GetN(), score, histoChi2->GetBinContent(iLifeTimeRange + 1));
       } // lifeTimeRanges
-      fileIn->Close();
+      if(fileIn != nullptr) fileIn->Close();
       ++iTargetSignal;
     } // targetSignals
   } // bdtScores
@@ -196,16 +205,17 @@ std::pair<double, double> EvaluateMeanAndStdDevOfGraph(const TGraph* graph, doub
 }
 
 int main(int argc, char* argv[]) {
+  const std::string storeFileName = ExtractStringOption(argc, argv, "--store", "");
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./raw_yield_vs_bdt_pdfer fileNameTemplate (histoName=hRawYieldsSignal)" << std::endl;
+    std::cout << " ./raw_yield_vs_bdt_pdfer fileNameTemplate (histoName=hRawYieldsSignal) (--store rawYieldStoreFileName)" << std::endl;
     exit(EXIT_FAILURE);
   }
 
   const std::string fileNameTemplate = argv[1];
   const std::string histoName = argc > 2 ? argv[2] : "hRawYieldsSignal";
 
-  raw_yield_vs_bdt_pdfer(fileNameTemplate, histoName);
+  raw_yield_vs_bdt_pdfer(fileNameTemplate, histoName, storeFileName);
 
   return 0;
 }
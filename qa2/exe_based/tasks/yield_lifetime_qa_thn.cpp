@@ -4,6 +4,8 @@
 
 #include "HelperGeneral.hpp"
 #include "HelperMath.hpp"
+#include "OutputSink.hpp"
+#include "THnSparseProjector.hpp"
 
 #include <TAxis.h>
 #include <THnSparse.h>
@@ -19,6 +21,7 @@ using namespace HelperMath;
 using namespace std::string_literals;
 
 bool gIsDoWeight{false};
+int gNThreads{1};
 std::vector<double> gBdtSignalLowerValues{};
 
 std::vector<double> pTRanges = {1, 2, 3, 4, 5, 8, 12, 20};
@@ -33,6 +36,7 @@ const std::string_view signalTypeAxisTitle = "candidates type";
 
 const std::string fileOutName{"yield_lifetime_qa_thn.root"};
 constexpr bool IsVerbose{true};
+bool gIsUseScanSuffixSums{true}; // project once to lifetime x NP score and read the thresholds out of suffix sums
 
 const std::vector<std::pair<std::string, double>> promptnesses {
   {"prompt", 1.},
@@ -58,57 +62,70 @@ void FillYield(const std::string& fileName, const std::string& filePtWeightName,
   TH1* histoWeightNonPrompt = gIsDoWeight ? GetObjectWithNullptrCheck<TH1>(fileWeight, "histoNPWeight") : nullptr;
   THnSparse* histoRecOrGen = GetObjectWithNullptrCheck<THnSparse>(fileIn, "hf-task-lc/"s + (isRec ? "hnLcVarsWithBdt" : "hnLcVarsGen"));
   const std::map<std::string_view, int> axesIndices = MapTHnSparseAxesIndices(histoRecOrGen);
-  THnSparse* histoPromptWeighted = gIsDoWeight ? dynamic_cast<THnSparse*>(histoRecOrGen->Clone()) : nullptr;
-  THnSparse* histoNonPromptWeighted = gIsDoWeight ? dynamic_cast<THnSparse*>(histoRecOrGen->Clone()) : nullptr;
-  if (gIsDoWeight) {
-    ScaleTHnSparseWithWeight(histoPromptWeighted, axesIndices.at(pTAxisTitle), histoWeightPrompt);
-    ScaleTHnSparseWithWeight(histoNonPromptWeighted, axesIndices.at(pTBAxisTitle), histoWeightNonPrompt);
-  }
-  
-  auto ProcessTHnSparse = [&](THnSparse* histoIn, const std::string& histoNameSuffix="", const std::vector<std::pair<std::string, double>>& promptnessesToProcess=promptnesses) {
+  OutputSink sink(fileOut);
+
+  // the weights are applied on the fly while projecting, no weighted clones of histoRecOrGen are made
+  auto ProcessTHnSparse = [&](const THnSparseWeightedView& histoView, const std::string& histoNameSuffix="", const std::vector<std::pair<std::string, double>>& promptnessesToProcess=promptnesses) {
     if(IsVerbose) std::cout << "ProcessTHnSparse() started\n";
+    const THnSparse* histoIn = histoView.histo_;
     CheckTAxisForRanges(*histoIn->GetAxis(axesIndices.at(pTAxisTitle)), pTRanges);
     CheckTAxisForRanges(*histoIn->GetAxis(axesIndices.at(signalTypeAxisTitle)), {1., 2., 3.});
     if(isRec) CheckTAxisForRanges(*histoIn->GetAxis(axesIndices.at(bgAxisTitle)), bdtBgUpperValuesVsPt);
 
+    // for rec - real gBdtSignalLowerValues; for gen - fake 1-element vector for universality reasons
+    const auto& bdtSignalLowerValues = isRec ? gBdtSignalLowerValues : std::vector<double>{UndefValueDouble};
+
+    // all the projections are built in a single pass over histoIn filled bins
+    THnSparseProjector projector(histoView, axesIndices.at(lifetimeAxisTitle));
+    if(isRec) projector.SetScanAxis(axesIndices.at(npAxisTitle));
+    projector.SetUseScanSuffixSums(gIsUseScanSuffixSums);
+    projector.SetNThreads(gNThreads);
+    std::vector<THnSparseProjector::Selection> pTSelections, promptnessSelections, bdtSelections;
+    for(size_t iPt=0, nPts=pTRanges.size()-1; iPt<nPts; ++iPt) {
+      THnSparseProjector::Selection pTSelection{{axesIndices.at(pTAxisTitle), static_cast<float>(pTRanges.at(iPt)), static_cast<float>(pTRanges.at(iPt + 1))}};
+      if(isRec) pTSelection.push_back({axesIndices.at(bgAxisTitle), 0.f, static_cast<float>(bdtBgUpperValuesVsPt.at(iPt))});
+      pTSelections.emplace_back(pTSelection);
+    }
+    for(const auto& promptness : promptnessesToProcess) {
+      promptnessSelections.push_back({{axesIndices.at(signalTypeAxisTitle), static_cast<float>(promptness.second), static_cast<float>(promptness.second+1.f)}});
+    }
+    for(const auto& bsc : bdtSignalLowerValues) {
+      if(isRec) bdtSelections.push_back({{axesIndices.at(npAxisTitle), static_cast<float>(bsc), 1.f}});
+      else      bdtSelections.push_back({});
+    }
+    projector.AddSliceDimension(pTSelections);
+    projector.AddSliceDimension(promptnessSelections);
+    projector.AddSliceDimension(bdtSelections);
+    projector.Run();
+
     for(size_t iPt=0, nPts=pTRanges.size()-1; iPt<nPts; ++iPt) {
       if(IsVerbose) std::cout << "ProcessTHnSparse(): iPt = " << iPt << "\n";
-      SetTHnSparseAxisRanges(histoIn, axesIndices.at(pTAxisTitle), pTRanges.at(iPt), pTRanges.at(iPt + 1));
-      if(isRec) SetTHnSparseAxisRanges(histoIn, axesIndices.at(bgAxisTitle), 0., bdtBgUpperValuesVsPt.at(iPt));
-      for(const auto& promptness : promptnessesToProcess) {
+      for(size_t iPromptness=0, nPromptnesses=promptnessesToProcess.size(); iPromptness<nPromptnesses; ++iPromptness) {
+        const auto& promptness = promptnessesToProcess.at(iPromptness);
         if(IsVerbose) std::cout << "ProcessTHnSparse(): promptness = " << promptness.first << "\n";
         const std::string dirName = (isRec ? "rec/" : "gen/") + promptness.first + "/" + GetPtCutName(iPt);
-        SetTHnSparseAxisRanges(histoIn, axesIndices.at(signalTypeAxisTitle), promptness.second, promptness.second+1.f);
-        // for rec - real gBdtSignalLowerValues; for gen - fake 1-element vector for universality reasons
-        const auto& bdtSignalLowerValues = isRec ? gBdtSignalLowerValues : std::vector<double>{UndefValueDouble};
         if(IsVerbose) std::cout << "ProcessTHnSparse(): bsc = ";
-        for(const auto& bsc : bdtSignalLowerValues) {
+        for(size_t iBsc=0, nBscs=bdtSignalLowerValues.size(); iBsc<nBscs; ++iBsc) {
+          const double bsc = bdtSignalLowerValues.at(iBsc);
           if(IsVerbose) std::cout << bsc << "\t";
           const std::string histoName = isRec ?
                                         "hT_NPgt" + to_string_with_precision(bsc, 2) + histoNameSuffix :
                                         "hT" + histoNameSuffix;
-          if(isRec) SetTHnSparseAxisRanges(histoIn, axesIndices.at(npAxisTitle), bsc, 1.);
-          TH1* histoYield = histoIn->Projection(axesIndices.at(lifetimeAxisTitle));
-          histoYield->SetDirectory(nullptr);
-          CD(fileOut, dirName);
-          histoYield->Write(histoName.c_str());
-          if(isRec) SetTHnSparseAxisRanges(histoIn, axesIndices.at(npAxisTitle));
+          sink.Add(dirName, projector.GetProjection({iPt, iPromptness, iBsc}), histoName);
         } // bdtSignalLowerValues
         if(IsVerbose) std::cout << "\n";
-        SetTHnSparseAxisRanges(histoIn, axesIndices.at(signalTypeAxisTitle));
       } // promptnessesToProcess
-      SetTHnSparseAxisRanges(histoIn, axesIndices.at(pTAxisTitle));
-      if(isRec) SetTHnSparseAxisRanges(histoIn, axesIndices.at(bgAxisTitle));
     } // pTRanges
     if(IsVerbose) std::cout << "ProcessTHnSparse() finished\n";
   };
   
   ProcessTHnSparse(histoRecOrGen);
   if (gIsDoWeight) {
-    ProcessTHnSparse(histoPromptWeighted, "_W", {promptnesses.at(0)});
-    ProcessTHnSparse(histoNonPromptWeighted, "_W", {promptnesses.at(1)});
+    ProcessTHnSparse({histoRecOrGen, axesIndices.at(pTAxisTitle), histoWeightPrompt}, "_W", {promptnesses.at(0)});
+    ProcessTHnSparse({histoRecOrGen, axesIndices.at(pTBAxisTitle), histoWeightNonPrompt}, "_W", {promptnesses.at(1)});
   }
 
+  sink.Flush();
   fileOut->Close();
   fileIn->Close();
   if (gIsDoWeight) fileWeight->Close();
@@ -121,9 +138,11 @@ std::string GetPtCutName(size_t iPt) {
 }
 
 int main(int argc, char* argv[]) {
+  gNThreads = ExtractIntOption(argc, argv, "--threads", 1);
+  gIsUseScanSuffixSums = ExtractIntOption(argc, argv, "--scan-suffix-sums", 1) != 0;
   if (argc < 2) {
     std::cout << "Error! Please use " << std::endl;
-    std::cout << " ./yield_lifetime_qa_thn fileNameIn (modeRun=RunOnly=0 [RunAndMerge=1, MergeOnly=2]) (filePtWeightName)" << std::endl;
+    std::cout << " ./yield_lifetime_qa_thn fileNameIn (modeRun=RunOnly=0 [RunAndMerge=1, MergeOnly=2]) (filePtWeightName) (--threads nThreads=1) (--scan-suffix-sums isUseScanSuffixSums=1)" << std::endl;
     exit(EXIT_FAILURE);
   }
   if(bdtBgUpperValuesVsPt.size() != pTRanges.size() - 1) throw std::runtime_error("bdtUpperValuesVsPt.size() != pTRanges.size() - 1");
@@ -159,6 +178,7 @@ int main(int argc, char* argv[]) {
 
   const std::string& mergedFileOutName = modeRun != MergeOnly ? fileOutName : fileName;
   TFile* fileOut = OpenFileWithNullptrCheck(mergedFileOutName.c_str(), "update");
+  OutputSink sink(fileOut);
 
   auto ProcessMerge = [&](const bool isRec) {
     for(const auto& promptness : promptnesses) {
@@ -175,8 +195,8 @@ int main(int argc, char* argv[]) {
                                     "gen/" + promptness.first + "/" + ptcn + "/hT" + weightPresence);
           } // pTCutNames
           TH1* histoMerged = MergeHistograms(fileOut, histoNames);
-          CD(fileOut, (isRec ? "rec/" : "gen/") + promptness.first + "/" + GetPtCutName(pTRanges.size() - 1));
-          histoMerged->Write((isRec ? "hT_NPgt" + to_string_with_precision(bslv, 2) + weightPresence : "hT" + weightPresence).c_str());
+          sink.Add((isRec ? "rec/" : "gen/") + promptness.first + "/" + GetPtCutName(pTRanges.size() - 1), histoMerged,
+                   isRec ? "hT_NPgt" + to_string_with_precision(bslv, 2) + weightPresence : "hT" + weightPresence);
         } // bdtSignalLowerValues
       } // weightPresences
     } // promptnesses
@@ -185,6 +205,7 @@ int main(int argc, char* argv[]) {
   ProcessMerge(true);
   ProcessMerge(false);
 
+  sink.Flush();
   fileOut->Close();
 
   return 0;
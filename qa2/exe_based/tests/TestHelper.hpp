@@ -0,0 +1,69 @@
+#ifndef QA2_TESTHELPER_HPP
+#define QA2_TESTHELPER_HPP
+
+#include <TH1D.h>
+#include <TRandom3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <string>
+
+// Minimal checks for the test executables: a failed check is reported and counted,
+// the test's main() returns the number of failures (0 for ctest success). And the synthetic spectra shared by the tests
+namespace TestHelper {
+inline int& Failures() {
+  static int failures{0};
+  return failures;
+}
+
+inline void Check(bool condition, const std::string& what) {
+  if(condition) return;
+  std::cout << "FAILED: " << what << "\n";
+  ++Failures();
+}
+
+inline void CheckClose(double value, double reference, double tolerance, const std::string& what) {
+  const double diff = std::fabs(value - reference);
+  const double scale = std::max(1., std::fabs(reference));
+  Check(diff <= tolerance * scale, what + ": " + std::to_string(value) + " vs " + std::to_string(reference));
+}
+
+/// Fills nSignal Gaussian entries and nBackground ones over the histogram's axis range distributed as backgroundShape(x),
+/// which must not exceed 1 (the rejection sampling), all with TRandom3(seed)
+inline void FillSpectrum(TH1* histo, double mean, double sigma, int nSignal, int nBackground, unsigned int seed,
+                         const std::function<double(double)>& backgroundShape=[](double) { return 1.; }) {
+  TRandom3 random(seed);
+  for(int iEntry=0; iEntry<nSignal; ++iEntry) {
+    histo->Fill(random.Gaus(mean, sigma));
+  }
+  const double xMin = histo->GetXaxis()->GetXmin();
+  const double xMax = histo->GetXaxis()->GetXmax();
+  for(int iEntry=0; iEntry<nBackground; ++iEntry) {
+    double x;
+    do {
+      x = random.Uniform(xMin, xMax);
+    } while(random.Uniform() > backgroundShape(x));
+    histo->Fill(x);
+  }
+}
+
+/// Invariant-mass spectrum "hMass_<seed>" with Sumw2, see FillSpectrum(); the caller owns it
+inline TH1D* MakeSpectrum(int nBins, double massMin, double massMax, double mean, double sigma, int nSignal, int nBackground, unsigned int seed,
+                          const std::function<double(double)>& backgroundShape) {
+  auto histo = new TH1D(("hMass_" + std::to_string(seed)).c_str(), "", nBins, massMin, massMax);
+  histo->SetDirectory(nullptr);
+  histo->Sumw2();
+  FillSpectrum(histo, mean, sigma, nSignal, nBackground, seed, backgroundShape);
+  return histo;
+}
+
+inline int Summary(const std::string& testName) {
+  if(Failures() == 0) std::cout << testName << ": all checks passed\n";
+  else                std::cout << testName << ": " << Failures() << " check(s) failed\n";
+  return Failures();
+}
+} // namespace TestHelper
+
+#endif //QA2_TESTHELPER_HPP
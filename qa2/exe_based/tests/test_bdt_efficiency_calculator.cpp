@@ -0,0 +1,88 @@
+#include "BdtEfficiencyCalculator.hpp"
+#include "TestHelper.hpp"
+
+#include <TH2D.h>
+#include <TRandom3.h>
+
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+namespace {
+// The efficiency as it was computed before the summed-area tables: TH2::Integral() per cut
+double EfficiencyWithIntegrals(const TH2* histo, int binx, int biny, bool xUpper, bool yUpper) {
+  const int nx = histo->GetNbinsX();
+  const int ny = histo->GetNbinsY();
+  const int fromX = xUpper ? 1 : binx+1;
+  const int toX = xUpper ? binx-1 : nx;
+  const int fromY = yUpper ? 1 : biny+1;
+  const int toY = yUpper ? biny-1 : ny;
+  const double integralInternal = (toX>fromX && toY>fromY) ? histo->Integral(fromX, toX, fromY, toY) : 0.;
+  const double integralEdgeVert = toY>fromY ? histo->Integral(binx, binx, fromY, toY)/2 : 0.;
+  const double integralEdgeHoriz = toX>fromX ? histo->Integral(fromX, toX, biny, biny)/2 : 0.;
+  const double integralCorner = histo->GetBinContent(binx, biny)/4;
+  return (integralInternal + integralEdgeVert + integralEdgeHoriz + integralCorner) / histo->Integral(1, nx, 1, ny);
+}
+
+// Fraction of the bin (i, j) which passes the cut (binx, biny), in the same convention as above
+double PassFraction(int i, int j, int binx, int biny, int nx, int ny, bool xUpper, bool yUpper) {
+  const int fromX = xUpper ? 1 : binx+1;
+  const int toX = xUpper ? binx-1 : nx;
+  const int fromY = yUpper ? 1 : biny+1;
+  const int toY = yUpper ? biny-1 : ny;
+  const bool inX = toX > fromX && i >= fromX && i <= toX;
+  const bool inY = toY > fromY && j >= fromY && j <= toY;
+  if(i == binx && j == biny) return 0.25;
+  if(i == binx && inY) return 0.5;
+  if(j == biny && inX) return 0.5;
+  if(inX && inY) return 1.;
+  return 0.;
+}
+
+// Weighted-binomial error by an explicit sum over the bins: d(eff)/d(w_ij) = (f_ij - eff)/total
+double BinomialErrorByBins(const TH2* histo, int binx, int biny, bool xUpper, bool yUpper, double eff) {
+  const int nx = histo->GetNbinsX();
+  const int ny = histo->GetNbinsY();
+  double err2{0.};
+  for(int i=1; i<=nx; i++) {
+    for(int j=1; j<=ny; j++) {
+      const double f = PassFraction(i, j, binx, biny, nx, ny, xUpper, yUpper);
+      const double e = histo->GetBinError(i, j);
+      err2 += e*e * (f - eff)*(f - eff);
+    }
+  }
+  return std::sqrt(err2) / histo->Integral(1, nx, 1, ny);
+}
+} // namespace
+
+int main() {
+  TRandom3 random(12345);
+  TH2D histo("histo", "", 13, 0., 1., 17, 0., 1.);
+  histo.Sumw2();
+  for(int iEntry=0; iEntry<20000; iEntry++) {
+    histo.Fill(random.Beta(2., 5.), random.Beta(3., 2.), random.Uniform(0.5, 1.5));
+  }
+
+  for(const auto& [xDirection, yDirection] : std::initializer_list<std::pair<std::string, std::string>>{{"up", "up"}, {"up", "low"}, {"low", "up"}, {"low", "low"}}) {
+    const bool xUpper = xDirection == "up";
+    const bool yUpper = yDirection == "up";
+    BdtEfficiencyCalculator calculator(&histo, xDirection, yDirection);
+    calculator.Run();
+    const TH2D* hEff = calculator.GetEfficiencyHistogram();
+    const TH2D* hRej = calculator.GetRejectionHistogram();
+    const std::string label = "x " + xDirection + ", y " + yDirection;
+    for(int i=1; i<=histo.GetNbinsX(); i++) {
+      for(int j=1; j<=histo.GetNbinsY(); j++) {
+        const std::string where = label + ", bin (" + std::to_string(i) + ", " + std::to_string(j) + ")";
+        const double effRef = EfficiencyWithIntegrals(&histo, i, j, xUpper, yUpper);
+        const double errRef = BinomialErrorByBins(&histo, i, j, xUpper, yUpper, effRef);
+        TestHelper::CheckClose(hEff->GetBinContent(i, j) / 100., effRef, 1e-10, "efficiency " + where);
+        TestHelper::CheckClose(hRej->GetBinContent(i, j) / 100., 1. - effRef, 1e-10, "rejection " + where);
+        TestHelper::CheckClose(calculator.GetEfficiency(i, j).second, errRef, 1e-10, "efficiency error " + where);
+        TestHelper::Check(hEff->GetBinError(i, j) == 0. && hRej->GetBinError(i, j) == 0., "no errors in the output histograms " + where);
+      }
+    }
+  }
+
+  return TestHelper::Summary("test_bdt_efficiency_calculator");
+}
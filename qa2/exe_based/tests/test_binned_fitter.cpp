@@ -0,0 +1,138 @@
+#include "BinnedFitter.hpp"
+#include "Shapes.hpp"
+#include "TestHelper.hpp"
+
+#include <RooAddPdf.h>
+#include <RooChebychev.h>
+#include <RooDataHist.h>
+#include <RooFitResult.h>
+#include <RooGaussian.h>
+#include <RooGlobalFunc.h>
+#include <RooMsgService.h>
+#include <RooRealVar.h>
+#include <TF1.h>
+#include <TH1D.h>
+#include <TMath.h>
+
+#include <cmath>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// Validation of BinnedFitter on synthetic spectra (Gaussian peak over a 2nd order polynomial) against TH1::Fit()
+// with the same function (chi2 and Poisson likelihood, with and without the analytic gradient) and against
+// the equivalent extended RooFit model (RooGaussian + RooChebychev) fitted with the chi2: the parameters and the chi2
+namespace {
+constexpr double kMassMin{2.12};
+constexpr double kMassMax{2.42};
+constexpr double kShift{2.286};
+
+double AllShape(const double* x, const double* par) {
+  return PolN::Shape(x, par) + Gaus::Shape(x, &par[PolN::nPars]);
+}
+
+void AllGradient(const double* x, const double* par, double* grad) {
+  PolN::Gradient(x, par, grad);
+  Gaus::Gradient(x, &par[PolN::nPars], &grad[PolN::nPars]);
+}
+
+TH1D* MakeSpectrum(int nSignal, int nBackground, unsigned int seed) {
+  return TestHelper::MakeSpectrum(150, kMassMin, kMassMax, 2.2865, 0.0075, nSignal, nBackground, seed,
+                                  [](double mass) { return 1. - 2. * (mass - kMassMin) * (kMassMax - mass); });
+}
+
+TF1* MakeFunction(const std::string& name, const TH1* histo) {
+  auto func = new TF1(name.c_str(), AllShape, kMassMin, kMassMax, PolN::nPars + Gaus::nPars);
+  const double background = histo->GetBinContent(histo->FindBin(kMassMin + 0.01));
+  func->FixParameter(PolN::kShift, kShift);
+  func->SetParameter(PolN::kConst, background);
+  func->SetParameter(PolN::kSlope, 0.);
+  func->SetParameter(PolN::kSecond, 0.);
+  func->FixParameter(PolN::kThird, 0.);
+  func->SetParameter(PolN::nPars + Gaus::kFactor, histo->GetMaximum() - background);
+  func->SetParLimits(PolN::nPars + Gaus::kFactor, 0., 10. * histo->GetMaximum());
+  func->FixParameter(PolN::nPars + Gaus::kShift, kShift);
+  func->SetParameter(PolN::nPars + Gaus::kMu, 0.);
+  func->SetParLimits(PolN::nPars + Gaus::kMu, -0.02, 0.02);
+  func->SetParameter(PolN::nPars + Gaus::kSigma, 0.01);
+  func->SetParLimits(PolN::nPars + Gaus::kSigma, 0.002, 0.05);
+  return func;
+}
+
+// the parameters of the two fits agree within the fraction of the parameter's error
+void CheckParameters(const TF1* func, const TF1* reference, double fractionOfError, const std::string& what) {
+  for(int iPar=0; iPar<func->GetNpar(); iPar++) {
+    const double error = reference->GetParError(iPar);
+    if(error <= 0) continue; // fixed
+    TestHelper::Check(std::fabs(func->GetParameter(iPar) - reference->GetParameter(iPar)) <= fractionOfError * error,
+                      what + ": parameter " + std::to_string(iPar) + " " + std::to_string(func->GetParameter(iPar)) + " vs " + std::to_string(reference->GetParameter(iPar)));
+    TestHelper::CheckClose(func->GetParError(iPar) / error, 1., 0.1, what + ": error of parameter " + std::to_string(iPar));
+  }
+}
+} // namespace
+
+int main() {
+  RooMsgService::instance().setGlobalKillBelow(RooFit::WARNING);
+  const BinnedFitter::Model modelNoGradient{EvaluateShapeBatch<AllShape>, nullptr};
+  const BinnedFitter::Model modelGradient{EvaluateShapeBatch<AllShape>, AllGradient};
+
+  for(const auto& [nSignal, nBackground, seed] : std::initializer_list<std::tuple<int, int, unsigned int>>{{5000, 100000, 1}, {2000, 200000, 2}, {20000, 50000, 3}}) {
+    std::unique_ptr<TH1D> histo(MakeSpectrum(nSignal, nBackground, seed));
+    const std::string label = "spectrum " + std::to_string(seed);
+
+    // chi2: TH1::Fit() is the reference
+    std::unique_ptr<TF1> funcRoot(MakeFunction("funcRoot", histo.get()));
+    TFitResultPtr resultRoot = histo->Fit(funcRoot.get(), "RS0Q");
+    TestHelper::Check(resultRoot->Status() == 0, label + ": TH1::Fit() converged");
+    for(const auto& [model, modelName] : {std::make_pair(modelNoGradient, "chi2"), std::make_pair(modelGradient, "chi2 with gradient")}) {
+      std::unique_ptr<TF1> func(MakeFunction("func", histo.get()));
+      TFitResultPtr result = BinnedFitter(histo.get(), kMassMin, kMassMax).Fit(func.get(), model);
+      const std::string what = label + ", " + modelName;
+      TestHelper::Check(result->Status() == 0, what + ": converged");
+      CheckParameters(func.get(), funcRoot.get(), 0.05, what + " vs TH1::Fit()");
+      TestHelper::CheckClose(result->MinFcnValue() / resultRoot->Chi2(), 1., 1e-4, what + ": chi2 vs TH1::Fit()");
+      TestHelper::Check(result->Ndf() == resultRoot->Ndf(), what + ": ndf vs TH1::Fit()");
+    }
+
+    // Poisson likelihood: TH1::Fit("L") is the reference
+    std::unique_ptr<TF1> funcRootL(MakeFunction("funcRootL", histo.get()));
+    histo->Fit(funcRootL.get(), "RS0QL");
+    for(const auto& [model, modelName] : {std::make_pair(modelNoGradient, "likelihood"), std::make_pair(modelGradient, "likelihood with gradient")}) {
+      std::unique_ptr<TF1> func(MakeFunction("func", histo.get()));
+      BinnedFitter(histo.get(), kMassMin, kMassMax, BinnedFitter::Statistic::kPoissonNLL).Fit(func.get(), model);
+      CheckParameters(func.get(), funcRootL.get(), 0.05, label + ", " + modelName + " vs TH1::Fit(\"L\")");
+    }
+
+    // chi2: the extended RooFit model of the same family, the yields are the Gaussian integrals in bins
+    RooRealVar mass("mass", "", kMassMin, kMassMax);
+    RooDataHist dataHist("dataHist", "", mass, RooFit::Import(*histo));
+    RooRealVar mean("mean", "", kShift, kShift - 0.02, kShift + 0.02);
+    RooRealVar sigma("sigma", "", 0.01, 0.002, 0.05);
+    RooGaussian gaus("gaus", "", mass, mean, sigma);
+    RooRealVar c1("c1", "", 0., -5., 5.);
+    RooRealVar c2("c2", "", 0., -5., 5.);
+    RooChebychev bkg("bkg", "", mass, RooArgList(c1, c2));
+    RooRealVar nSig("nSig", "", nSignal, 0., 10. * histo->Integral());
+    RooRealVar nBkg("nBkg", "", nBackground, 0., 10. * histo->Integral());
+    RooAddPdf model("model", "", RooArgList(gaus, bkg), RooArgList(nSig, nBkg));
+    std::unique_ptr<RooFitResult> resultRooFit(model.chi2FitTo(dataHist, RooFit::Extended(true), RooFit::DataError(RooAbsData::SumW2),
+                                                               RooFit::Save(), RooFit::PrintLevel(-1)));
+
+    std::unique_ptr<TF1> func(MakeFunction("func", histo.get()));
+    TFitResultPtr result = BinnedFitter(histo.get(), kMassMin, kMassMax).Fit(func.get(), modelGradient);
+    const std::string what = label + ", chi2 vs RooFit";
+    TestHelper::Check(resultRooFit->status() == 0, label + ": RooFit converged");
+    const double binWidth = histo->GetBinWidth(1);
+    const double factor = func->GetParameter(PolN::nPars + Gaus::kFactor);
+    const double sigmaFit = func->GetParameter(PolN::nPars + Gaus::kSigma);
+    const double nSigFit = factor * sigmaFit * std::sqrt(TMath::TwoPi()) / binWidth;
+    TestHelper::Check(std::fabs(kShift + func->GetParameter(PolN::nPars + Gaus::kMu) - mean.getVal()) <= 0.1 * mean.getError(), what + ": mean");
+    TestHelper::Check(std::fabs(sigmaFit - sigma.getVal()) <= 0.1 * sigma.getError(), what + ": sigma");
+    TestHelper::Check(std::fabs(nSigFit - nSig.getVal()) <= 0.1 * nSig.getError(), what + ": signal yield " + std::to_string(nSigFit) + " vs " + std::to_string(nSig.getVal()));
+    TestHelper::CheckClose(result->MinFcnValue() / resultRooFit->minNll(), 1., 1e-3, what + ": chi2");
+  }
+
+  return TestHelper::Summary("test_binned_fitter");
+}
@@ -0,0 +1,41 @@
+#include "HFInvMassFitter.h"
+#include "TestHelper.hpp"
+
+#include <RooMsgService.h>
+#include <TH1D.h>
+
+#include <memory>
+#include <string>
+
+// The chi2 / ndf of the headless fit (computed directly from the pdf) vs the one read from the RooPlot curves of the same fit
+// drawn: of the total fit and of the background sidebands' pre-fit, for the chi2 and the likelihood fits.
+// The curves are sampled adaptively by RooFit, hence the tolerance
+namespace {
+std::unique_ptr<HFInvMassFitter> Fit(const TH1* histo, bool isHeadless, bool isLikelihood) {
+  auto fitter = std::make_unique<HFInvMassFitter>(histo, 2.12, 2.42, HFInvMassFitter::Poly2, HFInvMassFitter::SingleGaus);
+  fitter->setHeadless(isHeadless);
+  fitter->setInitialGaussianMean(2.286);
+  fitter->setInitialGaussianSigma(0.008);
+  if(isLikelihood) fitter->setUseLikelihoodFit();
+  else             fitter->setUseChi2Fit();
+  fitter->doFit();
+  return fitter;
+}
+} // namespace
+
+int main() {
+  RooMsgService::instance().setGlobalKillBelow(RooFit::WARNING);
+  std::unique_ptr<TH1D> histo(TestHelper::MakeSpectrum(300, 2.12, 2.42, 2.286, 0.008, 10000, 200000, 1,
+                                                       [](double mass) { return 1. - 1.5 * (mass - 2.12); }));
+
+  for(const bool isLikelihood : {false, true}) {
+    const std::string what = isLikelihood ? "likelihood fit" : "chi2 fit";
+    const auto fitterHeadless = Fit(histo.get(), true, isLikelihood);
+    const auto fitterDrawn = Fit(histo.get(), false, isLikelihood);
+    TestHelper::CheckClose(fitterHeadless->getRawYield(), fitterDrawn->getRawYield(), 1e-9, what + ": the same fit in both modes");
+    TestHelper::CheckClose(fitterHeadless->getChiSquareOverNDFTotal(), fitterDrawn->getChiSquareOverNDFTotal(), 0.02, what + ": chi2 / ndf of the total fit");
+    TestHelper::CheckClose(fitterHeadless->getChiSquareOverNDFBkg(), fitterDrawn->getChiSquareOverNDFBkg(), 0.02, what + ": chi2 / ndf of the background");
+  }
+
+  return TestHelper::Summary("test_headless_chi2");
+}
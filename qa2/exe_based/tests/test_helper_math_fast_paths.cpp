@@ -0,0 +1,150 @@
+#include "HelperMath.hpp"
+#include "TestHelper.hpp"
+
+#include <TF1.h>
+#include <TH1D.h>
+#include <TRandom3.h>
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The direct-array kernels of HelperMath on plain TH1D histograms vs the generic per-bin path (HelperMath::SetUseFastPaths(false))
+// on the same inputs, with and without Sumw2: all the cells (incl. under- and overflow), the sums of weights squared,
+// the entries, the statistics (GetStats()) and the stored minimum and maximum must be the same bit for bit
+namespace {
+using Histos = std::vector<std::unique_ptr<TH1>>;
+
+bool IsSameBits(double a, double b) {
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/// Gaussian-distributed entries over 0..10 in 100 bins, with some entries in the under- and overflow.
+/// With Sumw2 the weights are random and can be negative, without Sumw2 a few bins are set negative
+TH1D* MakeHisto(const std::string& name, unsigned int seed, bool isSumw2, int nEntries=20000) {
+  TRandom3 random(seed);
+  auto histo = new TH1D(name.c_str(), "", 100, 0., 10.);
+  if(isSumw2) histo->Sumw2();
+  for(int iEntry=0; iEntry<nEntries; ++iEntry) {
+    histo->Fill(random.Gaus(5., 2.2), isSumw2 ? random.Uniform(-0.2, 1.5) : 1.);
+  }
+  if(!isSumw2) {
+    for(const int iBin : {7, 50, 93}) {
+      histo->SetBinContent(iBin, -random.Uniform(1., 5.));
+    }
+  }
+  return histo;
+}
+
+void CheckIdentical(const TH1* fast, const TH1* generic, const std::string& what) {
+  TestHelper::Check(fast->GetNcells() == generic->GetNcells(), what + ": number of cells");
+  TestHelper::Check(fast->GetSumw2N() == generic->GetSumw2N(), what + ": Sumw2 is " + std::to_string(fast->GetSumw2N()) + " vs " + std::to_string(generic->GetSumw2N()));
+  if(fast->GetNcells() != generic->GetNcells() || fast->GetSumw2N() != generic->GetSumw2N()) return;
+
+  int nDifferentContents{0};
+  int nDifferentSumw2{0};
+  for(int iCell=0; iCell<fast->GetNcells(); ++iCell) {
+    nDifferentContents += !IsSameBits(fast->GetBinContent(iCell), generic->GetBinContent(iCell));
+    if(fast->GetSumw2N() > 0) nDifferentSumw2 += !IsSameBits(fast->GetSumw2()->At(iCell), generic->GetSumw2()->At(iCell));
+  }
+  TestHelper::Check(nDifferentContents == 0, what + ": " + std::to_string(nDifferentContents) + " cell(s) differ in the content");
+  TestHelper::Check(nDifferentSumw2 == 0, what + ": " + std::to_string(nDifferentSumw2) + " cell(s) differ in the sum of weights squared");
+
+  TestHelper::Check(IsSameBits(fast->GetEntries(), generic->GetEntries()),
+                    what + ": entries " + std::to_string(fast->GetEntries()) + " vs " + std::to_string(generic->GetEntries()));
+  double statsFast[TH1::kNstat]{};
+  double statsGeneric[TH1::kNstat]{};
+  fast->GetStats(statsFast);
+  generic->GetStats(statsGeneric);
+  for(int iStat=0; iStat<TH1::kNstat; ++iStat) {
+    TestHelper::Check(IsSameBits(statsFast[iStat], statsGeneric[iStat]),
+                      what + ": stats[" + std::to_string(iStat) + "] " + std::to_string(statsFast[iStat]) + " vs " + std::to_string(statsGeneric[iStat]));
+  }
+  TestHelper::Check(IsSameBits(fast->GetMinimumStored(), generic->GetMinimumStored()) && IsSameBits(fast->GetMaximumStored(), generic->GetMaximumStored()),
+                    what + ": stored minimum and maximum");
+}
+
+/// operation() creates its inputs and returns the resulting histograms; it is run with the fast paths and without
+void Compare(const std::string& what, const std::function<Histos()>& operation) {
+  HelperMath::SetUseFastPaths(true);
+  const Histos fast = operation();
+  HelperMath::SetUseFastPaths(false);
+  const Histos generic = operation();
+  HelperMath::SetUseFastPaths(true);
+  for(size_t iHisto=0; iHisto<fast.size(); ++iHisto) {
+    CheckIdentical(fast.at(iHisto).get(), generic.at(iHisto).get(), what + ", output " + std::to_string(iHisto));
+  }
+}
+
+Histos Own(TH1* histo) {
+  Histos result;
+  result.emplace_back(histo);
+  return result;
+}
+} // namespace
+
+int main() {
+  TH1::AddDirectory(false);
+  TF1 func("func", "[0]*TMath::Gaus(x, [1], [2], true)", 0., 10.);
+  func.SetParameters(20000 * 0.1, 5., 2.2);
+
+  for(const bool isSumw2 : {true, false}) {
+    const std::string sumw2Text = isSumw2 ? " with Sumw2" : " without Sumw2";
+
+    for(const std::string option : {"", "I"}) {
+      Compare("EvalNormDifferenceHistoFromFunction(\"" + option + "\")" + sumw2Text, [&]() {
+        TH1* histo = MakeHisto("hNormDiff", 1, isSumw2);
+        HelperMath::EvalNormDifferenceHistoFromFunction(histo, &func, option);
+        return Own(histo);
+      });
+    }
+
+    Compare("InvertHisto" + sumw2Text, [&]() {
+      TH1* histo = MakeHisto("hInvert", 2, isSumw2);
+      HelperMath::InvertHisto(histo);
+      return Own(histo);
+    });
+
+    Compare("EvaluateEfficiencyHisto" + sumw2Text, [&]() {
+      // the numerator is a random subset of the denominator's entries
+      TRandom3 random(3);
+      std::unique_ptr<TH1D> hNum(new TH1D("hNum", "", 100, 0., 10.));
+      std::unique_ptr<TH1D> hDen(new TH1D("hDen", "", 100, 0., 10.));
+      if(isSumw2) {
+        hNum->Sumw2();
+        hDen->Sumw2();
+      }
+      for(int iEntry=0; iEntry<20000; ++iEntry) {
+        const double x = random.Gaus(5., 2.2);
+        hDen->Fill(x);
+        if(random.Uniform() < 0.3) hNum->Fill(x);
+      }
+      auto [hEff, hRelErr] = HelperMath::EvaluateEfficiencyHisto(hNum.get(), hDen.get());
+      Histos result = Own(hEff);
+      result.emplace_back(hRelErr);
+      return result;
+    });
+
+    Compare("CutSubHistogram" + sumw2Text, [&]() {
+      std::unique_ptr<TH1D> histo(MakeHisto("hCut", 4, isSumw2));
+      return Own(HelperMath::CutSubHistogram(histo.get(), 2., 7.));
+    });
+
+    // the addends alternate with and without Sumw2, starting as isSumw2
+    for(const int nAddends : {1, 2, 5}) {
+      Compare("MergeHistograms of " + std::to_string(nAddends) + sumw2Text + " first", [&]() {
+        Histos addends;
+        std::vector<TH1*> addendPtrs;
+        for(int iAddend=0; iAddend<nAddends; ++iAddend) {
+          addends.emplace_back(MakeHisto("hAddend" + std::to_string(iAddend), 10 + iAddend, (iAddend % 2 == 0) == isSumw2, 5000));
+          addendPtrs.emplace_back(addends.back().get());
+        }
+        return Own(HelperMath::MergeHistograms(addendPtrs));
+      });
+    }
+  }
+
+  return TestHelper::Summary("test_helper_math_fast_paths");
+}
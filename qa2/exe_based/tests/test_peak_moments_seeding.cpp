@@ -0,0 +1,72 @@
+#include "PeakMoments.hpp"
+#include "ShapeFitter.hpp"
+#include "Shapes.hpp"
+#include "TestHelper.hpp"
+
+#include <TH1D.h>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// The peak fits of ShapeFitter seeded with PeakMoments vs the default seeding by the expected mu and sigma,
+// on synthetic spectra whose peak is displaced from the expected position and is narrower or wider than expected.
+// A fit succeeds if it converges and finds the true mean and sigma within 3 errors. The moment seeding must succeed
+// at least as often, and either more often or with fewer function calls on average.
+// PeakMoments itself must find the mean and sigma of the subtracted peak within a fraction of sigma
+namespace {
+constexpr double kExpectedMu{2.286};
+constexpr double kExpectedSigma{0.01};
+
+struct Summary {
+  int n_succeeded_{0};
+  double n_calls_{0.};
+};
+} // namespace
+
+int main() {
+  constexpr int nSpectra{20};
+  for(const auto& [mean, sigma] : {std::make_pair(kExpectedMu + 0.02, 0.006), std::make_pair(kExpectedMu - 0.025, 0.016)}) {
+    const std::string scenario = "mean " + std::to_string(mean) + ", sigma " + std::to_string(sigma);
+    Summary summaryDefault, summaryMoments;
+    for(int iSpectrum=0; iSpectrum<nSpectra; ++iSpectrum) {
+      std::unique_ptr<TH1D> histo(TestHelper::MakeSpectrum(300, 2.12, 2.42, mean, sigma, 10000, 200000, 100 + iSpectrum,
+                                                           [](double mass) { return 1. - 1.5 * (mass - 2.12); }));
+
+      const PeakMoments moments = PeakMoments::Estimate(histo.get(), 2.12, 2.42);
+      TestHelper::Check(moments.is_valid_, scenario + ": moments are valid");
+      TestHelper::Check(std::fabs(moments.mean_ - mean) < 0.2 * sigma, scenario + ": moments mean " + std::to_string(moments.mean_));
+      TestHelper::Check(std::fabs(moments.sigma_ - sigma) < 0.3 * sigma, scenario + ": moments sigma " + std::to_string(moments.sigma_));
+
+      for(const bool isMomentEstimate : {false, true}) {
+        ShapeFitter shapeFitter(histo.get());
+        shapeFitter.SetExpectedMu(kExpectedMu);
+        shapeFitter.SetExpectedSigma(kExpectedSigma);
+        shapeFitter.SetSideBands(2.12, 2.20, 2.38, 2.42);
+        shapeFitter.SetPeakShape("Gaus");
+        shapeFitter.SetBgPolN(2);
+        shapeFitter.SetUseMomentEstimate(isMomentEstimate);
+        shapeFitter.Fit();
+
+        const TFitResultPtr result = shapeFitter.GetPeakFitResult();
+        const TF1* func = shapeFitter.GetPeakFunc();
+        const double meanFit = kExpectedMu + func->GetParameter(Gaus::kMu);
+        const double sigmaFit = func->GetParameter(Gaus::kSigma);
+        const bool isSucceeded = result->Status() == 0 &&
+                                 std::fabs(meanFit - mean) < 3 * func->GetParError(Gaus::kMu) &&
+                                 std::fabs(sigmaFit - sigma) < 3 * func->GetParError(Gaus::kSigma);
+        Summary& summary = isMomentEstimate ? summaryMoments : summaryDefault;
+        summary.n_succeeded_ += isSucceeded;
+        summary.n_calls_ += result->NCalls() / static_cast<double>(nSpectra);
+      }
+    }
+    std::cout << scenario << ": default seeding " << summaryDefault.n_succeeded_ << "/" << nSpectra << " succeeded, " << summaryDefault.n_calls_ << " calls on average; "
+              << "moment seeding " << summaryMoments.n_succeeded_ << "/" << nSpectra << " succeeded, " << summaryMoments.n_calls_ << " calls on average\n";
+    TestHelper::Check(summaryMoments.n_succeeded_ >= summaryDefault.n_succeeded_, scenario + ": the moment seeding succeeds at least as often");
+    TestHelper::Check(summaryMoments.n_succeeded_ > summaryDefault.n_succeeded_ || summaryMoments.n_calls_ < summaryDefault.n_calls_,
+                      scenario + ": the moment seeding succeeds more often or needs fewer calls");
+  }
+
+  return TestHelper::Summary("test_peak_moments_seeding");
+}
@@ -0,0 +1,64 @@
+#include "Shapes.hpp"
+#include "TestHelper.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+// Compares Gradient() with the central finite differences of Shape() over each parameter at each point.
+// The points closer than minDistance (in x) to any of the kinks are skipped, as the shape is not differentiable there
+template<double (*Shape)(const double*, const double*), void (*Gradient)(const double*, const double*, double*)>
+void CheckGradient(const std::string& shapeName, std::vector<double> par, const std::vector<double>& xs,
+                   const std::vector<double>& kinks={}, double minDistance=0.) {
+  const size_t nPars = par.size();
+  std::vector<double> grad(nPars);
+  for(const double x : xs) {
+    if(std::any_of(kinks.begin(), kinks.end(), [&](double kink) { return std::fabs(x - kink) < minDistance; })) continue;
+    Gradient(&x, par.data(), grad.data());
+    for(size_t iPar=0; iPar<nPars; iPar++) {
+      const double value = par.at(iPar);
+      const double step = 1e-6 * std::max(1., std::fabs(value));
+      par.at(iPar) = value + step;
+      const double up = Shape(&x, par.data());
+      par.at(iPar) = value - step;
+      const double down = Shape(&x, par.data());
+      par.at(iPar) = value;
+      const double numerical = (up - down) / (2 * step);
+      TestHelper::CheckClose(grad.at(iPar), numerical, 1e-5, shapeName + " d/dpar[" + std::to_string(iPar) + "] at x = " + std::to_string(x));
+    }
+  }
+}
+
+std::vector<double> Points(double from, double to, double step) {
+  std::vector<double> points;
+  for(double x=from; x<=to; x+=step) {
+    points.emplace_back(x);
+  }
+  return points;
+}
+} // namespace
+
+int main() {
+  const std::vector<double> xs = Points(-2., 2.5, 0.0371);
+
+  CheckGradient<PolN::Shape, PolN::Gradient>("PolN", {0.3, 1.5, -0.7, 0.4, 0.25}, xs);
+
+  CheckGradient<Gaus::Shape, Gaus::Gradient>("Gaus", {3., 0.2, 0.1, 0.5}, xs);
+
+  CheckGradient<DoubleGaus::Shape, DoubleGaus::Gradient>("DoubleGaus", {3., 1.2, 0.2, 0.1, 0.3, 0.8}, xs);
+
+  // both tails are covered: the core is |u| < a1, a2, i.e. x in (0.3 - 0.5*1.2, 0.3 + 0.5*1.8) = (-0.3, 1.2),
+  // with the tails down to u = -4.6 and up to u = 4.4; the tails' n = 10^0.5 and 10^0.3
+  const double shift{0.2}, mu{0.1}, sigma{0.5}, a1{1.2}, a2{1.8};
+  const std::vector<double> dscbKinks{shift + mu - a1 * sigma, shift + mu + a2 * sigma};
+  CheckGradient<DoubleSidedCrystalBall::Shape, DoubleSidedCrystalBall::Gradient>("DSCB", {3., shift, mu, sigma, a1, 0.5, a2, 0.3}, xs, dscbKinks, 1e-3);
+  // a steeper left tail (small n) and a softer right one (large n)
+  CheckGradient<DoubleSidedCrystalBall::Shape, DoubleSidedCrystalBall::Gradient>("DSCB steep tail", {1., shift, mu, sigma, 0.8, 0.1, 2.5, 1.2}, xs,
+                                                                                 {shift + mu - 0.8 * sigma, shift + mu + 2.5 * sigma}, 1e-3);
+  // the tail points must actually be present in the scan
+  TestHelper::Check(xs.front() < dscbKinks.front() && xs.back() > dscbKinks.back(), "DSCB tails are covered by the points");
+
+  return TestHelper::Summary("test_shapes_gradient");
+}
@@ -0,0 +1,82 @@
+#include "TemplatePdf.h"
+#include "TestHelper.hpp"
+
+#include <RooArgSet.h>
+#include <RooDataHist.h>
+#include <RooGlobalFunc.h>
+#include <RooHistPdf.h>
+#include <RooMsgService.h>
+#include <RooRealVar.h>
+#include <TH1D.h>
+#include <TH1F.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// TemplatePdf built from a TH1F template (and from a variable-binning one) vs RooHistPdf with intOrder = 1 of the same
+// template, which it replaces: the normalised values, the integral over a sub-range, and the unnormalised integral,
+// which for a uniform binning is also the histogram's integral. The pdf must keep the template's binning and contents:
+// the same values for the clone and for the pdf built from the equivalent TH1D template.
+// The RooHistPdf integrals are numerical, hence the tolerance
+namespace {
+template<typename H>
+std::unique_ptr<H> MakeTemplate(const std::string& name, const std::vector<double>& edges, bool isUniform) {
+  std::unique_ptr<H> histo = isUniform ? std::make_unique<H>(name.c_str(), "", static_cast<int>(edges.size()) - 1, edges.front(), edges.back()) :
+                                         std::make_unique<H>(name.c_str(), "", static_cast<int>(edges.size()) - 1, edges.data());
+  histo->SetDirectory(nullptr);
+  histo->Sumw2();
+  TestHelper::FillSpectrum(histo.get(), 2.27, 0.04, 20000, 0, 1);
+  return histo;
+}
+
+void CheckPdf(const std::string& what, const TH1* histoTemplate, const TH1* histoReference, bool isUniform) {
+  RooRealVar x("x", "x", histoTemplate->GetXaxis()->GetXmin(), histoTemplate->GetXaxis()->GetXmax());
+  x.setRange("signal", 2.25, 2.31);
+  TemplatePdf pdf("pdf", "pdf", x, histoTemplate);
+  TemplatePdf pdfReference("pdfReference", "pdfReference", x, histoReference);
+  std::unique_ptr<TemplatePdf> pdfClone(dynamic_cast<TemplatePdf*>(pdf.clone("pdfClone")));
+  RooDataHist dataHist("dataHist", "dataHist", x, RooFit::Import(*histoTemplate));
+  RooHistPdf histPdf("histPdf", "histPdf", x, dataHist, 1);
+
+  const RooArgSet normSet(x);
+  for(int iPoint=0; iPoint<50; ++iPoint) {
+    x.setVal(x.getMin() + (x.getMax() - x.getMin()) * (iPoint + 0.5) / 50.);
+    const double expected = histPdf.getVal(normSet);
+    const std::string where = what + " at x = " + std::to_string(x.getVal());
+    TestHelper::CheckClose(pdf.getVal(normSet), expected, 1e-4, where + ": pdf vs RooHistPdf");
+    TestHelper::CheckClose(pdfClone->getVal(normSet), pdf.getVal(normSet), 1e-12, where + ": clone vs pdf");
+    TestHelper::CheckClose(pdfReference.getVal(normSet), pdf.getVal(normSet), 1e-6, where + ": TH1F vs TH1D template");
+  }
+
+  std::unique_ptr<RooAbsReal> integral(pdf.createIntegral(x, RooFit::NormSet(x), RooFit::Range("signal")));
+  std::unique_ptr<RooAbsReal> integralHistPdf(histPdf.createIntegral(x, RooFit::NormSet(x), RooFit::Range("signal")));
+  TestHelper::CheckClose(integral->getVal(), integralHistPdf->getVal(), 1e-4, what + ": integral over the signal range");
+
+  std::unique_ptr<RooAbsReal> norm(pdf.createIntegral(x));
+  std::unique_ptr<RooAbsReal> normHistPdf(histPdf.createIntegral(x));
+  TestHelper::CheckClose(norm->getVal() / normHistPdf->getVal(), 1., 1e-4, what + ": unnormalised integral vs RooHistPdf");
+  if(isUniform) {
+    TestHelper::CheckClose(norm->getVal() / histoTemplate->Integral(), 1., 1e-9, what + ": unnormalised integral vs the histogram");
+  }
+}
+} // namespace
+
+int main() {
+  RooMsgService::instance().setGlobalKillBelow(RooFit::WARNING);
+  std::vector<double> edgesUniform;
+  for(int iEdge=0; iEdge<=60; ++iEdge) {
+    edgesUniform.push_back(2.12 + 0.005 * iEdge);
+  }
+  const std::vector<double> edgesVariable{2.12, 2.15, 2.19, 2.22, 2.24, 2.25, 2.26, 2.27, 2.28, 2.29, 2.30, 2.32, 2.35, 2.39, 2.42};
+
+  for(const bool isUniform : {true, false}) {
+    const std::string binning = isUniform ? "uniform binning" : "variable binning";
+    auto histoF = MakeTemplate<TH1F>("hTemplateF", isUniform ? edgesUniform : edgesVariable, isUniform);
+    auto histoD = MakeTemplate<TH1D>("hTemplateD", isUniform ? edgesUniform : edgesVariable, isUniform);
+    CheckPdf("TH1F template, " + binning, histoF.get(), histoD.get(), isUniform);
+    CheckPdf("TH1D template, " + binning, histoD.get(), histoF.get(), isUniform);
+  }
+
+  return TestHelper::Summary("test_template_pdf");
+}
@@ -0,0 +1,104 @@
+#include "HelperGeneral.hpp"
+#include "THnSparseProjector.hpp"
+#include "TestHelper.hpp"
+
+#include <TH1D.h>
+#include <THnSparse.h>
+#include <TRandom3.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// THnSparseProjector vs THnSparse::Projection() with the same axis ranges set on a clone of the input,
+// for a (mass, pT, score, ct) THnSparse with and without Sumw2: contents and errors in all the bins.
+// The score is the scan axis, with the suffix sums and without them. The weighted view is compared to the projection
+// of the clone scaled with HelperGeneral::ScaleTHnSparseWithWeight()
+namespace {
+constexpr int kMassAxis{0};
+constexpr int kPtAxis{1};
+constexpr int kScoreAxis{2};
+constexpr int kCtAxis{3};
+
+/// With Sumw2 the entries have random weights, without it unit ones
+THnSparseD* MakeSparse(bool isSumw2) {
+  const int nBins[4] = {40, 10, 20, 8};
+  const double xMin[4] = {2.1, 0., 0., 0.};
+  const double xMax[4] = {2.5, 10., 1., 2.};
+  auto histo = new THnSparseD("histo", "", 4, nBins, xMin, xMax);
+  if(isSumw2) histo->Sumw2();
+  TRandom3 random(1);
+  for(int iEntry=0; iEntry<200000; ++iEntry) {
+    const double point[4] = {random.Uniform(2.1, 2.5), random.Uniform(0., 10.), random.Uniform(), random.Uniform(0., 2.)};
+    histo->Fill(point, isSumw2 ? random.Uniform(0.5, 1.5) : 1.);
+  }
+  return histo;
+}
+
+/// Projection() of the clone (weighted along the pT axis if histoWeight is given) with the ranges of all the selections' cuts set
+TH1D* ReferenceProjection(const THnSparse* histo, const TH1* histoWeight, const std::vector<THnSparseProjector::Selection>& selections) {
+  std::unique_ptr<THnSparse> clone(dynamic_cast<THnSparse*>(histo->Clone()));
+  if(histoWeight != nullptr) HelperGeneral::ScaleTHnSparseWithWeight(clone.get(), kPtAxis, histoWeight);
+  for(const auto& selection : selections) {
+    for(const auto& cut : selection) {
+      HelperGeneral::SetTHnSparseAxisRanges(clone.get(), cut.axis_, cut.lo_, cut.hi_);
+    }
+  }
+  TH1D* projection = clone->Projection(kMassAxis, clone->GetCalculateErrors() ? "E" : "");
+  projection->SetDirectory(nullptr);
+  return projection;
+}
+
+void CheckSameProjection(const TH1* projection, const TH1* reference, const std::string& what) {
+  for(int iBin=0; iBin<=reference->GetNbinsX()+1; ++iBin) {
+    const std::string where = what + ", bin " + std::to_string(iBin);
+    TestHelper::CheckClose(projection->GetBinContent(iBin), reference->GetBinContent(iBin), 1e-9, where + " content");
+    TestHelper::CheckClose(projection->GetBinError(iBin), reference->GetBinError(iBin), 1e-9, where + " error");
+  }
+}
+
+/// pT slices (with an overlapping one), and "score > threshold" selections combined with a ct range
+void CheckProjector(const THnSparse* histo, const TH1* histoWeight, bool isUseScanSuffixSums, const std::string& what) {
+  const std::vector<THnSparseProjector::Selection> ptSelections{{{kPtAxis, 0.f, 2.f}}, {{kPtAxis, 2.f, 6.f}}, {{kPtAxis, 1.f, 10.f}}, {}};
+  std::vector<THnSparseProjector::Selection> scoreSelections;
+  for(const float threshold : {0.f, 0.3f, 0.5f, 0.95f}) {
+    scoreSelections.push_back({{kScoreAxis, threshold, 1.f}, {kCtAxis, 0.25f, 1.5f}});
+  }
+
+  THnSparseProjector projector(histoWeight != nullptr ? THnSparseWeightedView(histo, kPtAxis, histoWeight) : THnSparseWeightedView(histo), kMassAxis);
+  projector.SetScanAxis(kScoreAxis);
+  projector.SetUseScanSuffixSums(isUseScanSuffixSums);
+  projector.AddSliceDimension(ptSelections);
+  projector.AddSliceDimension(scoreSelections);
+  projector.Run();
+
+  for(size_t iPt=0; iPt<ptSelections.size(); ++iPt) {
+    for(size_t iScore=0; iScore<scoreSelections.size(); ++iScore) {
+      std::unique_ptr<TH1D> projection(projector.GetProjection({iPt, iScore}));
+      std::unique_ptr<TH1D> reference(ReferenceProjection(histo, histoWeight, {ptSelections.at(iPt), scoreSelections.at(iScore)}));
+      CheckSameProjection(projection.get(), reference.get(), what + ", pT selection " + std::to_string(iPt) + ", score selection " + std::to_string(iScore));
+    }
+  }
+}
+} // namespace
+
+int main() {
+  TH1::AddDirectory(false);
+  TH1D histoWeight("histoWeight", "", 20, 0., 10.);
+  for(int iBin=1; iBin<=histoWeight.GetNbinsX(); ++iBin) {
+    histoWeight.SetBinContent(iBin, 1. + 0.1 * histoWeight.GetBinCenter(iBin));
+  }
+
+  for(const bool isSumw2 : {true, false}) {
+    std::unique_ptr<THnSparseD> histo(MakeSparse(isSumw2));
+    for(const TH1* weight : {static_cast<const TH1*>(nullptr), static_cast<const TH1*>(&histoWeight)}) {
+      for(const bool isUseScanSuffixSums : {true, false}) {
+        const std::string what = std::string(isSumw2 ? "with Sumw2" : "without Sumw2") + (weight != nullptr ? ", weighted" : "") +
+                                 (isUseScanSuffixSums ? ", suffix sums" : ", no suffix sums");
+        CheckProjector(histo.get(), weight, isUseScanSuffixSums, what);
+      }
+    }
+  }
+
+  return TestHelper::Summary("test_thnsparse_projector");
+}